@@ -16,6 +16,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <cerrno>
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
@@ -36,6 +37,8 @@
 #include "eixrc/eixrc.h"
 #include "eixrc/global.h"
 #include "portage/conf/portagesettings.h"
+#include "portage/package.h"
+#include "portage/version.h"
 
 extern char **environ;
 
@@ -57,6 +60,20 @@ class EbuildExecSettings {
 		bool init_ebuild_sh(const EbuildExec *e);
 };
 
+EbuildJob::EbuildJob(const char *n, const string& d, const Package& package, const Version& v, const string& e) :
+	name(n), dir(d), category(package.category), package_name(package.name), eapi(e),
+	version(v), pid(-1), status(0), started(false), finished(false) {
+}
+
+bool EbuildJob::finish(pid_t child, int exit_status) {
+	if((!started) || finished || ((child != -1) && (child != pid))) {
+		return false;
+	}
+	finished = true;
+	status = exit_status;
+	return true;
+}
+
 EbuildExec *EbuildExec::handler_arg;
 
 void ebuild_sig_handler(int sig) {
@@ -73,6 +90,9 @@ void ebuild_sig_handler(int sig) {
 // this is not a problem from "outside" this class.
 
 void EbuildExec::add_handler() {
+	if(have_set_signals) {
+		return;
+	}
 GCC_DIAG_OFF(old-style-cast)
 	handler_arg = this;
 	// Set the signals "empty" to avoid a race condition:
@@ -139,7 +159,7 @@ void EbuildExec::remove_handler() {
 }
 
 // You should have called add_handler() in advance
-int EbuildExec::make_tempfile() {
+int EbuildExec::make_tempfile(string *file) {
 	const string &tmpdir = settings->tmpdir;
 	string::size_type l(tmpdir.size());
 	char *temp = new char[256 + l];
@@ -154,8 +174,7 @@ int EbuildExec::make_tempfile() {
 		delete[] temp;
 		return fd;
 	}
-	cachefile.assign(temp);
-	cache_defined = true;
+	file->assign(temp);
 	delete[] temp;
 	return fd;
 }
@@ -174,16 +193,18 @@ void EbuildExec::delete_cachefile() {
 	} else {
 		base->m_error_callback(eix::format(_("tempfile %s is not a file")) % c);
 	}
-	remove_handler();
+	if(jobqueue.empty()) {
+		remove_handler();
+	}
 	cache_defined = false;
 	cachefile.clear();
 }
 
 /**
-This is a subfunction of make_cachefile() to ensure that make_cachefile()
+This is a subfunction of start_job() to ensure that start_job()
 has no local variable when vfork() is called.
 **/
-void EbuildExec::calc_environment(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi, int fd) {
+void EbuildExec::calc_environment(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi, const string& dbkey, int fd) {
 	c_env = NULLPTR;
 	envstrings = NULLPTR;
 	// non-sh: environment is kept except for possibly new PORTDIR_OVERLAY
@@ -208,7 +229,7 @@ void EbuildExec::calc_environment(const char *name, const string& dir, const Pac
 	// if(use_ebuild_sh)
 	{  // NOLINT(whitespace/braces)
 		base->env_add_package(&env, package, version, dir, name);
-		env["dbkey"] = cachefile;
+		env["dbkey"] = dbkey;
 		const string& portage_rootpath(settings->portage_rootpath);
 		if(likely(!portage_rootpath.empty())) {
 			env["PORTAGE_ROOTPATH"] = portage_rootpath;
@@ -264,29 +285,32 @@ void EbuildExec::calc_environment(const char *name, const string& dir, const Pac
 
 static CONSTEXPR const int EXECLE_FAILED = 127;
 
-string *EbuildExec::make_cachefile(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi) {
-	if(unlikely(!calc_settings())) {
-		return NULLPTR;
-	}
-
-	// Make cachefile and calculate exec_name
+/**
+A status which is neither a normal exit nor a signal
+**/
+static CONSTEXPR const int STATUS_UNKNOWN = 0x7f;
 
+void EbuildExec::start_job(EbuildJob *job) {
+	job->started = true;
+	job->finished = true;
 	add_handler();
 	int fd = -1;
 	if(use_ebuild_sh) {
 		exec_name = settings->exec_ebuild_sh.c_str();
-		fd = make_tempfile();
+		fd = make_tempfile(&(job->cachefile));
 		if(fd == -1) {
 			base->m_error_callback(_("creation of tempfile failed"));
-			remove_handler();
-			return NULLPTR;
+			return;
 		}
 	} else {
 		exec_name = "ebuild";
-		cachefile = settings->ebuild_depend_temp;
-		cache_defined = true;
+		job->cachefile = settings->ebuild_depend_temp;
+	}
+	exec_ebuild = job->name.c_str();
+	{
+		Package package(job->category, job->package_name);
+		calc_environment(exec_ebuild, job->dir, package, job->version, job->eapi, job->cachefile, fd);
 	}
-	calc_environment(name, dir, package, version, eapi, fd);
 #ifndef HAVE_SETENV
 	if((!use_ebuild_sh) && (c_env != NULLPTR)) {
 		exec_name = settings->exec_ebuild.c_str();
@@ -298,24 +322,19 @@ string *EbuildExec::make_cachefile(const char *name, const string& dir, const Pa
 #else
 	pid_t child = fork();
 #endif
-	if(unlikely(child == -1)) {
-		base->m_error_callback(_("forking failed"));
-		return NULLPTR;
-	}
 	if(child == 0) {
 		if(use_ebuild_sh) {
 			execle(exec_name, exec_name, "depend", static_cast<const char *>(NULLPTR), c_env);
 		} else {
 #ifndef HAVE_SETENV
 			if(c_env != NULLPTR)
-				execle(exec_name, exec_name, name, "depend", static_cast<const char *>(NULLPTR), c_env);
+				execle(exec_name, exec_name, exec_ebuild, "depend", static_cast<const char *>(NULLPTR), c_env);
 			else
 #endif
-				execlp(exec_name, exec_name, name, "depend", static_cast<const char *>(NULLPTR));
+				execlp(exec_name, exec_name, exec_ebuild, "depend", static_cast<const char *>(NULLPTR));
 		}
 		_exit(EXECLE_FAILED);
 	}
-	while(waitpid(child, &exec_status, 0) != child ) { }
 	if(fd != -1) {
 		close(fd);
 	}
@@ -324,6 +343,143 @@ string *EbuildExec::make_cachefile(const char *name, const string& dir, const Pa
 	delete[] c_env;
 	delete envstrings;
 
+	if(unlikely(child == -1)) {
+		base->m_error_callback(_("forking failed"));
+		if(use_ebuild_sh) {
+			unlink(job->cachefile.c_str());
+		}
+		return;
+	}
+	job->pid = child;
+	job->finished = false;
+	++running_jobs;
+}
+
+void EbuildExec::fill_jobs() {
+	while((running_jobs < max_jobs) && (first_unstarted < jobqueue.size())) {
+		start_job(jobqueue[first_unstarted++]);
+	}
+}
+
+void EbuildExec::wait_job(EbuildJob *awaited) {
+	int status;
+	pid_t child(waitpid(-1, &status, 0));
+	if(unlikely(child == -1)) {
+		if(errno == EINTR) {
+			return;
+		}
+		// Our children have been reaped elsewhere: We cannot know the status
+		awaited->finish(child, STATUS_UNKNOWN);
+		for(JobQueue::const_iterator it(jobqueue.begin());
+			likely(it != jobqueue.end()); ++it) {
+			(*it)->finish(child, STATUS_UNKNOWN);
+		}
+		running_jobs = 0;
+		return;
+	}
+	if(awaited->finish(child, status)) {
+		--running_jobs;
+		return;
+	}
+	for(JobQueue::const_iterator it(jobqueue.begin());
+		likely(it != jobqueue.end()); ++it) {
+		if((*it)->finish(child, status)) {
+			--running_jobs;
+			return;
+		}
+	}
+}
+
+void EbuildExec::drop_job(EbuildJob *job) {
+	if(job->pid != -1) {
+		if(!job->finished) {
+			int status;
+			while(waitpid(job->pid, &status, 0) != job->pid) {
+				if(errno != EINTR) {
+					break;
+				}
+			}
+			--running_jobs;
+		}
+		if(use_ebuild_sh) {
+			unlink(job->cachefile.c_str());
+		}
+	}
+	delete job;
+}
+
+void EbuildExec::prefetch(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi) {
+	if((max_jobs <= 1) || unlikely(!calc_settings())) {
+		return;
+	}
+	jobqueue.push_back(new EbuildJob(name, dir, package, version, eapi));
+	fill_jobs();
+}
+
+void EbuildExec::clear_prefetch() {
+	if(jobqueue.empty()) {
+		return;
+	}
+	for(JobQueue::iterator it(jobqueue.begin());
+		likely(it != jobqueue.end()); ++it) {
+		drop_job(*it);
+	}
+	jobqueue.clear();
+	first_unstarted = 0;
+	if(!cache_defined) {
+		remove_handler();
+	}
+}
+
+string *EbuildExec::make_cachefile(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi) {
+	if(unlikely(!calc_settings())) {
+		return NULLPTR;
+	}
+
+	// Take the prefetched job, dropping those which were predicted wrongly
+	EbuildJob *job(NULLPTR);
+	while(!jobqueue.empty()) {
+		EbuildJob *front(jobqueue.front());
+		jobqueue.pop_front();
+		if(first_unstarted != 0) {
+			--first_unstarted;
+		}
+		if(likely(front->name == name)) {
+			job = front;
+			break;
+		}
+		drop_job(front);
+	}
+	if(job == NULLPTR) {
+		job = new EbuildJob(name, dir, package, version, eapi);
+	}
+	for(;;) {
+		if((!job->started) && (running_jobs < max_jobs)) {
+			start_job(job);
+		}
+		fill_jobs();
+		if(job->finished || unlikely(got_exit_signal)) {
+			break;
+		}
+		wait_job(job);
+	}
+	if(job->pid == -1) {
+		delete job;
+		if(jobqueue.empty()) {
+			remove_handler();
+		}
+		return NULLPTR;
+	}
+	if(unlikely(!job->finished)) {
+		jobqueue.push_front(job);
+		++first_unstarted;
+	} else {
+		cachefile.swap(job->cachefile);
+		cache_defined = true;
+		exec_status = job->status;
+		delete job;
+	}
+
 GCC_DIAG_OFF(old-style-cast)
 	// Only now we check for the child exit status or signals:
 	if(unlikely(got_exit_signal)) {
@@ -334,8 +490,11 @@ GCC_DIAG_OFF(old-style-cast)
 		base->m_error_callback(eix::format(_("ebuild got signal %s")) % type_of_exit_signal);
 	}
 	if(unlikely(got_exit_signal)) {
+		int sig(type_of_exit_signal);
+		clear_prefetch();
 		delete_cachefile();
-		raise(type_of_exit_signal);
+		remove_handler();
+		raise(sig);
 		return NULLPTR;
 	}
 	if(likely(WIFEXITED(exec_status))) {
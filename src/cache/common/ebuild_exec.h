@@ -12,25 +12,55 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <sys/types.h>
+
 #include <csignal>
 
+#include <deque>
 #include <string>
 
 #include "eixTk/attribute.h"
 #include "eixTk/stringtypes.h"
+#include "portage/version.h"
 
 class EbuildExecSettings;
 class BasicCache;
 class Package;
-class Version;
 
 void ebuild_sig_handler(int sig);
 
+/**
+An ebuild execution which was queued in advance by EbuildExec::prefetch()
+**/
+class EbuildJob {
+		friend class EbuildExec;
+
+	private:
+		std::string name, dir, category, package_name, eapi, cachefile;
+		Version version;
+		pid_t pid;
+		int status;
+		bool started, finished;
+
+		ATTRIBUTE_NONNULL_ EbuildJob(const char *n, const std::string& d, const Package& package, const Version& v, const std::string& e);
+
+		/**
+		Mark the running job as finished if child is its process
+		(or if child is -1)
+		@return true if the job was marked
+		**/
+		bool finish(pid_t child, int exit_status);
+};
+
 class EbuildExec {
 		friend void ebuild_sig_handler(int sig);
 		friend class EbuildExecSettings;
 
+	public:
+		typedef unsigned int JobCount;
+
 	private:
+		typedef std::deque<EbuildJob *> JobQueue;
 		const BasicCache *base;
 		static EbuildExec *handler_arg;
 		volatile bool have_set_signals, got_exit_signal, cache_defined;
@@ -45,34 +75,92 @@ class EbuildExec {
 #endif
 		bool use_ebuild_sh;
 		/**
-		local data for make_cachefile which should be saved for vfork
+		local data for start_job which should be saved for vfork
 		**/
-		const char *exec_name;
+		const char *exec_name, *exec_ebuild;
 		const char **c_env;
 		int exec_status;
 		WordVec *envstrings;
-		ATTRIBUTE_NONNULL_ void calc_environment(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi, int fd);
+		ATTRIBUTE_NONNULL_ void calc_environment(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi, const std::string& dbkey, int fd);
+
+		/**
+		The jobs in the order in which their results are expected;
+		the jobs before index first_unstarted have been started
+		**/
+		JobQueue jobqueue;
+		JobQueue::size_type first_unstarted;
+		JobCount max_jobs, running_jobs;
 
 		static EbuildExecSettings *settings;
 
 		void add_handler();
 		void remove_handler();
-		int make_tempfile();
+		ATTRIBUTE_NONNULL_ int make_tempfile(std::string *file);
 		bool portageq(std::string *result, const char *var) const;
 		bool calc_settings();
 
+		/**
+		Start the ebuild process for job.
+		In case of failure, job is marked as finished and pid is -1.
+		**/
+		ATTRIBUTE_NONNULL_ void start_job(EbuildJob *job);
+		/**
+		Start queued jobs until max_jobs processes are running
+		**/
+		void fill_jobs();
+		/**
+		Wait until some process (of awaited or of a queued job) has finished
+		or a signal arrived
+		**/
+		ATTRIBUTE_NONNULL_ void wait_job(EbuildJob *awaited);
+		/**
+		Wait for the process of job (if necessary), remove its tempfile,
+		and delete job
+		**/
+		ATTRIBUTE_NONNULL_ void drop_job(EbuildJob *job);
+
 	public:
 		ATTRIBUTE_NONNULL_ std::string *make_cachefile(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi);
 		void delete_cachefile();
 
+		/**
+		Queue the execution which make_cachefile() will be called with later.
+		Up to jobs() processes are run in parallel in the background;
+		the results are nevertheless used in the order of the calls.
+		This does nothing unless jobs() > 1.
+		**/
+		ATTRIBUTE_NONNULL_ void prefetch(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi);
+
+		/**
+		Drop all queued executions which were not used by make_cachefile()
+		**/
+		void clear_prefetch();
+
+		/**
+		Set the maximal number of processes to be run in parallel.
+		This is ignored (i.e. 1) if ebuild.sh is not used.
+		**/
+		void set_jobs(JobCount n) {
+			max_jobs = ((use_ebuild_sh && (n > 1)) ? n : 1);
+		}
+
+		JobCount jobs() const {
+			return max_jobs;
+		}
+
 		ATTRIBUTE_NONNULL_ EbuildExec(bool will_use_sh, const BasicCache *b) :
 			base(b),
 			have_set_signals(false),
+			got_exit_signal(false),
 			cache_defined(false),
-			use_ebuild_sh(will_use_sh) {
+			use_ebuild_sh(will_use_sh),
+			first_unstarted(0),
+			max_jobs(1),
+			running_jobs(0) {
 		}
 
 		~EbuildExec() {
+			clear_prefetch();
 			delete_cachefile();
 		}
 
@@ -85,7 +85,7 @@ void FlatReader::get_keywords_slot_iuse_restrict(const string& filename, string
 		string pdepend, bdepend;
 		getline(is, pdepend);
 		getline(is, bdepend);
-		dep->set(depend, rdepend, pdepend, bdepend, idepend, false);
+		dep->set(depend, rdepend, pdepend, bdepend, idepend);
 	} else {
 		skip_lines((use_required_use ? 2 : 3), &is, filename);
 	}
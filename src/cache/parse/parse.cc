@@ -13,6 +13,7 @@
 #include <ctime>
 
 #include <string>
+#include <vector>
 
 #include "cache/base.h"
 #include "cache/common/assign_reader.h"
@@ -85,6 +86,10 @@ bool ParseCache::initialize(const string& name) {
 			ebuild_type = (portage3_0_24 ? "ebuild-3.0.24" : "ebuild-legacy");
 		}
 		ebuild_exec = new EbuildExec(ebuild_sh, this);
+		// getInteger() would let a negative value wrap around
+		if(my_atos(eixrc["EBUILD_JOBS"].c_str()) > 1) {
+			ebuild_exec->set_jobs(eixrc.getInteger("EBUILD_JOBS"));
+		}
 	}
 	while(++it_name != names.end()) {
 		MetadataCache *p(new MetadataCache);
@@ -192,69 +197,109 @@ void ParseCache::set_checking(string *str, const char *item, const VarsReader& e
 	}
 }
 
-void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version) {
-	string keywords, restr, props, iuse, required_use, slot, eapi;
-	bool ok(try_parse);
-	if(ok || ebuild_sh) {
-		VarsReader::Flags flags(VarsReader::NONE);
-		if(!read_onetime_info) {
-			flags |= VarsReader::ONLY_KEYWORDS_SLOT;
+void ParseCache::read_vars(EbuildVars *vars, const char *fullpath, const string& dirpath, bool read_onetime_info, const Package& pkg, const Version& version) {
+	vars->read_onetime_info = read_onetime_info;
+	vars->parsed = vars->ok = try_parse;
+	vars->parse_failed = false;
+	if(!(vars->ok || ebuild_sh)) {
+		return;
+	}
+	VarsReader::Flags flags(VarsReader::NONE);
+	if(!read_onetime_info) {
+		flags |= VarsReader::ONLY_KEYWORDS_SLOT;
+	}
+	WordIterateMap env;
+	if(!nosubst) {
+		flags |= VarsReader::INTO_MAP | VarsReader::SUBST_VARS;
+		env_add_package(&env, pkg, version, dirpath, fullpath);
+	}
+	VarsReader ebuild(flags);
+	if(flags & VarsReader::INTO_MAP) {
+		ebuild.useMap(&env);
+	}
+	if(!ebuild.read(fullpath, &(vars->errtext), false)) {
+		vars->parse_failed = true;
+	}
+
+	bool& ok(vars->ok);
+	if(ok) {
+		set_checking(&(vars->keywords), "KEYWORDS", ebuild, &ok);
+		set_checking(&(vars->slot), "SLOT", ebuild, &ok);
+		// Empty SLOT is not ok:
+		if(ok && (ebuild_exec != NULLPTR) && vars->slot.empty()) {
+			ok = false;
 		}
-		WordIterateMap env;
-		if(!nosubst) {
-			flags |= VarsReader::INTO_MAP | VarsReader::SUBST_VARS;
-			env_add_package(&env, *pkg, *version, dirpath, fullpath);
+		set_checking(&(vars->restr), "RESTRICT", ebuild);
+		set_checking(&(vars->props), "PROPERTIES", ebuild);
+		set_checking(&(vars->iuse), "IUSE", ebuild, &ok);
+		if(Version::use_required_use) {
+			set_checking(&(vars->required_use), "REQUIRED_USE", ebuild);
 		}
-		VarsReader ebuild(flags);
-		if(flags & VarsReader::INTO_MAP) {
-			ebuild.useMap(&env);
+		if(Depend::use_depend) {
+			set_checking(&(vars->depend), "DEPEND", ebuild);
+			set_checking(&(vars->rdepend), "RDEPEND", ebuild);
+			set_checking(&(vars->pdepend), "PDEPEND", ebuild);
+			set_checking(&(vars->bdepend), "BDEPEND", ebuild);
+			set_checking(&(vars->bdepend), "IDEPEND", ebuild);
 		}
-		string errtext;
-		if(!ebuild.read(fullpath, &errtext, false)) {
-			m_error_callback(eix::format(_("cannot properly parse %s: %s")) % fullpath % errtext);
+		if(ExtendedVersion::use_src_uri) {
+			set_checking(&(vars->src_uri), "SRC_URI", ebuild);
 		}
+		if(read_onetime_info) {
+			set_checking(&(vars->homepage), "HOMEPAGE",    ebuild, &ok);
+			set_checking(&(vars->licenses), "LICENSE",     ebuild, &ok);
+			set_checking(&(vars->desc),     "DESCRIPTION", ebuild, &ok);
+		}
+	}
+	const string *s(ebuild.find("EAPI"));
+	if(likely(s != NULLPTR)) {
+		vars->eapi = *s;
+	} else {
+		vars->eapi.assign("0");
+	}
+}
 
-		if(ok) {
-			set_checking(&keywords, "KEYWORDS", ebuild, &ok);
-			set_checking(&slot, "SLOT", ebuild, &ok);
-			// Empty SLOT is not ok:
-			if(ok && (ebuild_exec != NULLPTR) && slot.empty()) {
-				ok = false;
-			}
-			set_checking(&restr, "RESTRICT", ebuild);
-			set_checking(&props, "PROPERTIES", ebuild);
-			set_checking(&iuse, "IUSE", ebuild, &ok);
-			if(Version::use_required_use) {
-				set_checking(&required_use, "REQUIRED_USE", ebuild);
-			}
-			if(Depend::use_depend) {
-				string depend, rdepend, pdepend, bdepend, idepend;
-				set_checking(&depend, "DEPEND", ebuild);
-				set_checking(&rdepend, "RDEPEND", ebuild);
-				set_checking(&pdepend, "PDEPEND", ebuild);
-				set_checking(&bdepend, "BDEPEND", ebuild);
-				set_checking(&bdepend, "IDEPEND", ebuild);
-				version->depend.set(depend, rdepend, pdepend, bdepend, idepend, true);
-			}
-			if(ExtendedVersion::use_src_uri) {
-				string src_uri;
-				set_checking(&src_uri, "SRC_URI", ebuild);
-				version->src_uri = src_uri;
-			}
-			if(read_onetime_info) {
-				set_checking(&(pkg->homepage), "HOMEPAGE",    ebuild, &ok);
-				set_checking(&(pkg->licenses), "LICENSE",     ebuild, &ok);
-				set_checking(&(pkg->desc),     "DESCRIPTION", ebuild, &ok);
-				*have_onetime_info = true;
-			}
+void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version, bool prefetch) {
+	if(prefetch) {
+		EbuildVars& vars(prefetched[fullpath]);
+		read_vars(&vars, fullpath, dirpath, read_onetime_info, *pkg, *version);
+		if(vars.parsed && read_onetime_info) {
+			*have_onetime_info = true;
 		}
-		const string *s(ebuild.find("EAPI"));
-		if(likely(s != NULLPTR)) {
-			eapi = *s;
-		} else {
-			eapi.assign("0");
+		if(!vars.ok) {
+			ebuild_exec->prefetch(fullpath, dirpath, *pkg, *version, vars.eapi);
+		}
+		return;
+	}
+	// Reuse the variables read by the prefetch if possible
+	EbuildVars parsed;
+	EbuildVars *vars(&parsed);
+	PrefetchedVars::iterator found(prefetched.find(fullpath));
+	if((found != prefetched.end()) &&
+		(found->second.read_onetime_info == read_onetime_info)) {
+		vars = &(found->second);
+	} else {
+		read_vars(&parsed, fullpath, dirpath, read_onetime_info, *pkg, *version);
+	}
+	if(vars->parse_failed) {
+		m_error_callback(eix::format(_("cannot properly parse %s: %s")) % fullpath % vars->errtext);
+	}
+	// The values are used even if an execution overrides them later
+	if(vars->parsed) {
+		if(Depend::use_depend) {
+			version->depend.set(vars->depend, vars->rdepend, vars->pdepend, vars->bdepend, vars->idepend);
+		}
+		if(ExtendedVersion::use_src_uri) {
+			version->src_uri = vars->src_uri;
+		}
+		if(read_onetime_info) {
+			pkg->homepage = vars->homepage;
+			pkg->licenses = vars->licenses;
+			pkg->desc = vars->desc;
+			*have_onetime_info = true;
 		}
 	}
+	bool ok(vars->ok);
 	if(verbose) {
 		const char *used_type;
 		if(ok) {
@@ -267,10 +312,10 @@ void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool re
 			used_type);
 	}
 	if(!ok) {
-		string *cachefile(ebuild_exec->make_cachefile(fullpath, dirpath, *pkg, *version, eapi));
+		string *cachefile(ebuild_exec->make_cachefile(fullpath, dirpath, *pkg, *version, vars->eapi));
 		if(likely(cachefile != NULLPTR)) {
 			BasicReader *reader(newReader());
-			reader->get_keywords_slot_iuse_restrict(*cachefile, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
+			reader->get_keywords_slot_iuse_restrict(*cachefile, &(vars->eapi), &(vars->keywords), &(vars->slot), &(vars->iuse), &(vars->required_use), &(vars->restr), &(vars->props), &(version->depend), &(version->src_uri));
 			reader->read_file(*cachefile, pkg);
 			delete reader;
 			ebuild_exec->delete_cachefile();
@@ -278,14 +323,17 @@ void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool re
 			m_error_callback(eix::format(_("cannot properly execute %s")) % fullpath);
 		}
 	}
-	version->eapi.assign(eapi);
-	version->set_slotname(slot);
-	version->set_full_keywords(keywords);
-	version->set_restrict(restr);
-	version->set_properties(props);
-	version->set_iuse(iuse);
-	version->set_required_use(required_use);
+	version->eapi.assign(vars->eapi);
+	version->set_slotname(vars->slot);
+	version->set_full_keywords(vars->keywords);
+	version->set_restrict(vars->restr);
+	version->set_properties(vars->props);
+	version->set_iuse(vars->iuse);
+	version->set_required_use(vars->required_use);
 	pkg->addVersionFinalize(version);
+	if(vars != &parsed) {
+		prefetched.erase(found);
+	}
 }
 
 BasicReader *ParseCache::newReader() {
@@ -296,44 +344,91 @@ BasicReader *ParseCache::newReader() {
 	}
 }
 
-void ParseCache::readPackage(Category *cat, const string& pkg_name, const string& directory_path, const WordVec& files) {
+ParseCache::FurtherCaches::const_iterator ParseCache::find_further(const string& pkg_name, const string& curr_version, const string& full_path) const {
+	bool know_ebuild_time(false), have_ebuild_time(false);
+	std::time_t ebuild_time;
+	FurtherCaches::const_iterator it(further.begin());
+	for(; likely(it != further.end()); ++it) {
+		const char *s((*it)->get_md5sum(pkg_name, curr_version));
+		if(s != NULLPTR) {
+			if(verify_md5sum(full_path.c_str(), s)) {
+				break;
+			}
+			continue;
+		}
+		std::time_t t;
+		if((*it)->get_time(&t, pkg_name, curr_version)) {
+			if(!know_ebuild_time) {
+				know_ebuild_time = true;
+				have_ebuild_time = get_mtime(&ebuild_time, full_path.c_str());
+			}
+			if(unlikely(!have_ebuild_time)) {
+				break;
+			}
+			if(t >= ebuild_time) {
+				break;
+			}
+		}
+	}
+	return it;
+}
+
+Version *ParseCache::new_version(string *curr_version, const string& directory_path, const string& filename, bool quiet) {
+	string::size_type pos(ebuild_pos(filename));
+	if(pos == string::npos) {
+		return NULLPTR;
+	}
+
+	/* Check if we can split it */
+	if(unlikely(!ExplodeAtom::split_version(curr_version, filename.substr(0, pos).c_str()))) {
+		if(!quiet) {
+			m_error_callback(eix::format(_("cannot split filename of ebuild %s/%s")) %
+				directory_path % filename);
+		}
+		return NULLPTR;
+	}
+
+	/* Make version */
+	Version *version(new Version);
+	string errtext;
+	BasicVersion::ParseResult r(version->parseVersion(*curr_version, &errtext));
+	if(unlikely(r != BasicVersion::parsedOK) && !quiet) {
+		m_error_callback(errtext);
+	}
+	if(unlikely(r == BasicVersion::parsedError)) {
+		delete version;
+		return NULLPTR;
+	}
+	version->overlay_key = m_overlay_key;
+	return version;
+}
+
+/**
+If prefetch is true, the package is only parsed to queue the ebuild
+executions which the actual reading will need
+**/
+void ParseCache::readPackage(Category *cat, const string& pkg_name, const string& directory_path, const WordVec& files, bool prefetch) {
 	bool have_onetime_info, have_pkg;
 
-	Package *pkg(cat->findPackage(pkg_name));
+	Package *existing(cat->findPackage(pkg_name));
+	have_onetime_info = (existing != NULLPTR);
+	Package *pkg(prefetch ? NULLPTR : existing);
 	if(pkg != NULLPTR) {
-		have_onetime_info = have_pkg = true;
+		have_pkg = true;
 	} else {
-		have_onetime_info = have_pkg = false;
+		have_pkg = false;
 		pkg = new Package(m_catname, pkg_name);
 	}
 
 	for(WordVec::const_iterator fileit(files.begin());
 		likely(fileit != files.end()); ++fileit) {
-		string::size_type pos(ebuild_pos(*fileit));
-		if(pos == string::npos) {
-			continue;
-		}
-
-		/* Check if we can split it */
 		string curr_version;
-		if(unlikely(!ExplodeAtom::split_version(&curr_version, fileit->substr(0, pos).c_str()))) {
-			m_error_callback(eix::format(_("cannot split filename of ebuild %s/%s")) %
-				directory_path % (*fileit));
+		Version *version(new_version(&curr_version, directory_path, *fileit, prefetch));
+		if(version == NULLPTR) {
 			continue;
 		}
 
-		/* Make version and add it to package. */
-		Version *version(new Version);
-		string errtext;
-		BasicVersion::ParseResult r(version->parseVersion(curr_version, &errtext));
-		if(unlikely(r != BasicVersion::parsedOK)) {
-			m_error_callback(errtext);
-		}
-		if(unlikely(r == BasicVersion::parsedError)) {
-			delete version;
-			continue;
-		}
-		version->overlay_key = m_overlay_key;
+		/* Add version to package. */
 		pkg->addVersionStart(version);
 
 		string full_path(directory_path + '/' + (*fileit));
@@ -341,38 +436,26 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 		/* For the latest version read/change corresponding data */
 		bool read_onetime_info(true);
 		if(have_onetime_info) {
-			if(*(pkg->latest()) != *version) {
-				read_onetime_info = false;
-			}
-		}
-
-		bool know_ebuild_time(false), have_ebuild_time(false);
-		std::time_t ebuild_time;
-		FurtherCaches::const_iterator it(further.begin());
-		for(; likely(it != further.end()); ++it) {
-			const char *s((*it)->get_md5sum(pkg_name, curr_version));
-			if(s != NULLPTR) {
-				if(verify_md5sum(full_path.c_str(), s)) {
-					break;
+			const Version *latest(pkg->latest());
+			if(have_pkg != (existing != NULLPTR)) {
+				// pkg is a scratch copy: Compare also with the real one
+				const Version *real_latest(existing->latest());
+				if(*latest < *real_latest) {
+					latest = real_latest;
 				}
-				continue;
 			}
-			std::time_t t;
-			if((*it)->get_time(&t, pkg_name, curr_version)) {
-				if(!know_ebuild_time) {
-					know_ebuild_time = true;
-					have_ebuild_time = get_mtime(&ebuild_time, full_path.c_str());
-				}
-				if(unlikely(!have_ebuild_time)) {
-					break;
-				}
-				if(t >= ebuild_time) {
-					break;
-				}
+			if(*latest != *version) {
+				read_onetime_info = false;
 			}
 		}
+
+		FurtherCaches::const_iterator it(find_further(pkg_name, curr_version, full_path));
 		if(it == further.end()) {
-			parse_exec(full_path.c_str(), directory_path, read_onetime_info, &have_onetime_info, pkg, version);
+			parse_exec(full_path.c_str(), directory_path, read_onetime_info, &have_onetime_info, pkg, version, prefetch);
+		} else if(prefetch) {
+			if(read_onetime_info) {
+				have_onetime_info = true;
+			}
 		} else {
 			if(verbose) {
 				m_error_callback(eix::format("%s/%s-%s: %s") %
@@ -387,11 +470,11 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 		}
 	}
 
-	if(have_onetime_info) {
+	if(have_onetime_info && !prefetch) {
 		if(!have_pkg) {
 			cat->addPackage(pkg);
 		}
-	} else {
+	} else if(!have_pkg) {
 		delete pkg;
 	}
 }
@@ -408,6 +491,10 @@ bool ParseCache::readCategoryPrepare(const char *cat_name) {
 }
 
 void ParseCache::readCategoryFinalize() {
+	if(ebuild_exec != NULLPTR) {
+		ebuild_exec->clear_prefetch();
+	}
+	prefetched.clear();
 	further_works.clear();
 	for(FurtherCaches::iterator it(further.begin());
 		likely(it != further.end()); ++it) {
@@ -419,12 +506,31 @@ void ParseCache::readCategoryFinalize() {
 }
 
 bool ParseCache::readCategory(Category *cat) {
-	for(WordVec::const_iterator pit(m_packages.begin());
-		likely(pit != m_packages.end()); ++pit) {
-		string pkg_path(m_catpath + '/' + (*pit));
-		WordVec files;
-		if(scandir_cc(pkg_path, &files, ebuild_selector)) {
-			readPackage(cat, *pit, pkg_path, files);
+	if((ebuild_exec == NULLPTR) || (ebuild_exec->jobs() <= 1)) {
+		for(WordVec::const_iterator pit(m_packages.begin());
+			likely(pit != m_packages.end()); ++pit) {
+			string pkg_path(m_catpath + '/' + (*pit));
+			WordVec files;
+			if(scandir_cc(pkg_path, &files, ebuild_selector)) {
+				readPackage(cat, *pit, pkg_path, files, false);
+			}
+		}
+		return true;
+	}
+	// Queue all ebuild executions of the category first so that they can
+	// run in parallel while we read the packages in the usual order
+	std::vector<WordVec> package_files(m_packages.size());
+	std::vector<bool> have_files(m_packages.size());
+	for(WordVec::size_type i(0); likely(i < m_packages.size()); ++i) {
+		string pkg_path(m_catpath + '/' + m_packages[i]);
+		have_files[i] = scandir_cc(pkg_path, &(package_files[i]), ebuild_selector);
+		if(have_files[i]) {
+			readPackage(cat, m_packages[i], pkg_path, package_files[i], true);
+		}
+	}
+	for(WordVec::size_type i(0); likely(i < m_packages.size()); ++i) {
+		if(have_files[i]) {
+			readPackage(cat, m_packages[i], m_catpath + '/' + m_packages[i], package_files[i], false);
 		}
 	}
 	return true;
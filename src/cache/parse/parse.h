@@ -12,6 +12,7 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -41,13 +42,51 @@ class ParseCache FINAL : public BasicCache {
 		WordVec m_packages;
 		std::string m_catpath;
 
+		/**
+		The variables of an ebuild which parse_exec() needs
+		**/
+		class EbuildVars {
+			public:
+				std::string keywords, restr, props, iuse, required_use, slot, eapi;
+				std::string depend, rdepend, pdepend, bdepend, idepend, src_uri;
+				std::string homepage, licenses, desc, errtext;
+				bool read_onetime_info, parsed, ok, parse_failed;
+		};
+		/**
+		The variables read while prefetching, indexed by the ebuild path
+		**/
+		typedef std::map<std::string, EbuildVars> PrefetchedVars;
+		PrefetchedVars prefetched;
+
 		ATTRIBUTE_NONNULL((2, 3)) void set_checking(std::string *str, const char *item, const VarsReader& ebuild, bool *ok);
 		ATTRIBUTE_NONNULL_ void set_checking(std::string *str, const char *item, const VarsReader& ebuild) {
 			set_checking(str, item, ebuild, NULLPTR);
 		}
 
-		ATTRIBUTE_NONNULL_ void parse_exec(const char *fullpath, const std::string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version);
-		ATTRIBUTE_NONNULL_ void readPackage(Category *cat, const std::string& pkg_name, const std::string& directory_path, const WordVec& files);
+		/**
+		Read the variables of an ebuild. vars->parsed tells whether they
+		were tried, vars->ok whether they suffice or ebuild.sh must be
+		executed.
+		**/
+		ATTRIBUTE_NONNULL_ void read_vars(EbuildVars *vars, const char *fullpath, const std::string& dirpath, bool read_onetime_info, const Package& pkg, const Version& version);
+
+		/**
+		If prefetch is true, only determine whether the ebuild needs to be
+		executed and queue this execution; pkg and version are then scratch
+		objects which do not end up in the tree. The variables read are
+		kept for the actual reading.
+		**/
+		ATTRIBUTE_NONNULL_ void parse_exec(const char *fullpath, const std::string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version, bool prefetch);
+		/**
+		@return the first further cache with up-to-date data for the ebuild
+		**/
+		FurtherCaches::const_iterator find_further(const std::string& pkg_name, const std::string& curr_version, const std::string& full_path) const;
+		/**
+		Split the filename of an ebuild and create the corresponding version
+		@return NULLPTR on error (which is reported unless quiet)
+		**/
+		ATTRIBUTE_NONNULL_ Version *new_version(std::string *curr_version, const std::string& directory_path, const std::string& filename, bool quiet);
+		ATTRIBUTE_NONNULL_ void readPackage(Category *cat, const std::string& pkg_name, const std::string& directory_path, const WordVec& files, bool prefetch);
 		BasicReader *newReader();
 
 	public:
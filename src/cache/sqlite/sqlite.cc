@@ -16,6 +16,7 @@
 #include <sqlite3.h>
 
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/formated.h"
@@ -26,6 +27,7 @@
 #ifdef WITH_SQLITE
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/unordered_map.h"
 #include "portage/basicversion.h"
@@ -42,41 +44,24 @@ using std::string;
 
 
 
-/**
-All stuff related to our sqlite_callback()
-Essentially, this is just a C-wrapper to get the implicit this argument in
-*/
-SqliteCache *SqliteCache::callback_arg;
-
 ATTRIBUTE_CONST inline static const char *welldefine(const char *s);
 
 inline static const char *welldefine(const char *s) {
 	return ((s != NULLPTR) ? s : "");
 }
 
-int sqlite_callback(void * /* NotUsed */, int argc, char **argv, char **azColName) {
-#ifdef SQLITE_ONLY_DEBUG
-	for(int i(0); likely(i < argc); ++i) {
-		eix::say("%s: %s = %s")
-			% i % azColName[i] % welldefine(argv[i]);
-	}
-#else
-	SqliteCache::callback_arg->sqlite_callback_cpp(argc, const_cast<const char *const *>(argv), const_cast<const char *const *>(azColName));
-#endif
-	return 0;
-}
-
 /**
 The following is all related to get the proper index for the lookups.
 The main idea is the following: We let
 SqliteCache::trueindex[TrueIndex::Names] = actual index or negative
 where the negative value indicates that the data is not available
-because the sqlite dataset is too short; the minimal dataset length
-for all mandatory data is stored in SqliteCache::maxindex.
+because the sqlite dataset is too short or because we do not need it.
+The actual index is first the column in the table; afterwards, only the
+required columns are selected, and it becomes the column in this selection.
 
 The class TrueIndex and the static (and only) instance *true_index
-is used to calculate the initial value of trueindex/maxindex
-at the first database access by first filling it with default parameters
+is used to calculate the initial value of trueindex
+at each database access by first filling it with default parameters
 and - for the case that appropriate data is stored in azColName -
 modifying this correspondingly: This has the advantage that if some
 portage versions use different names, we still have (hopefully correct)
@@ -148,7 +133,11 @@ class TrueIndex : public TrueIndexMapper {
 			// 22 "_mtime_"
 		}
 
-		ATTRIBUTE_NONNULL_ int calc(int argc, const char *const *azColName, SqliteCache::TrueIndexMap *trueindex) const {
+		/**
+		Calculate the columns of the table for all Names
+		@return false if some mandatory column is missing
+		**/
+		ATTRIBUTE_NONNULL_ bool calc(int argc, const char *const *azColName, SqliteCache::TrueIndexMap *trueindex) const {
 			*trueindex = default_trueindex;
 			for(int i(0); i < argc; ++i) {
 				TrueIndexMapper::const_iterator it(find(azColName[i]));
@@ -156,24 +145,39 @@ class TrueIndex : public TrueIndexMapper {
 					(*trueindex)[it->second] = i;
 				}
 			}
-			int max_index(-1);
+			bool ok(true);
 			for(TrueIndexRes i(0); likely(i < TrueIndex::LAST); ++i) {
-				int curr((*trueindex)[i]);
-				// Shortcut if we have not reached the maximum
-				if(max_index >= curr) {
-					continue;
-				}
 				// Is the true index out of range?
-				if(argc <= curr) {
+				if(argc <= (*trueindex)[i]) {
 					(*trueindex)[i] = -1;
-					// PROPERTIES is not mandatory
-					if(i == TrueIndex::PROPERTIES) {
-						continue;
-					}
 				}
-				max_index = curr;
+				// PROPERTIES is not mandatory
+				if(((*trueindex)[i] < 0) && (i != TrueIndex::PROPERTIES)) {
+					ok = false;
+				}
+			}
+			return ok;
+		}
+
+		/**
+		@return true if the column is actually stored in the database
+		**/
+		ATTRIBUTE_PURE static bool needed(TrueIndexRes i) {
+			switch(i) {
+				case DEPEND:
+				case RDEPEND:
+				case PDEPEND:
+				case BDEPEND:
+				case IDEPEND:
+					return Depend::use_depend;
+				case REQUIRED_USE:
+					return Version::use_required_use;
+				case SRC_URI:
+					return ExtendedVersion::use_src_uri;
+				default:
+					break;
 			}
-			return max_index;
+			return true;
 		}
 
 		ATTRIBUTE_NONNULL((2)) static const char *c_str(const char *const *argv, SqliteCache::TrueIndexMap *trueindex, const TrueIndexRes i) {
@@ -187,35 +191,19 @@ class TrueIndex : public TrueIndexMapper {
 
 TrueIndex *SqliteCache::true_index = NULLPTR;
 
-void SqliteCache::sqlite_callback_cpp(int argc, const char *const *argv, const char *const *azColName) {
-	// If an earlier error occurred, we ignore later calls:
-	if(unlikely(sqlite_callback_error)) {
-		return;
-	}
-
-	if(maxindex == 0) {
-		if(unlikely(true_index == NULLPTR)) {
-			true_index = new TrueIndex;
-		}
-		maxindex = true_index->calc(argc, azColName, &trueindex);
-	}
-
-	if(argc <= trueindex[TrueIndex::NAME]) {
-		sqlite_callback_error = true;
-		m_error_callback(_("sqlite dataset does not contain a package name"));
-		return;
+bool SqliteCache::add_row(PackageTree *packagetree, const char *cat_name, const char *const *argv, Category *category) {
+#ifdef SQLITE_ONLY_DEBUG
+	for(TrueIndexRes i(0); likely(i < TrueIndex::LAST); ++i) {
+		eix::say("%s: %s = %s")
+			% i % trueindex[i] % TrueIndex::c_str(argv, &trueindex, i);
 	}
+	return true;
+#else
 	string catarg(TrueIndex::c_str(argv, &trueindex, TrueIndex::NAME));
-	if(argc <= maxindex) {
-		sqlite_callback_error = true;
-		m_error_callback(eix::format(_("sqlite dataset for %s is too small")) % catarg);
-		return;
-	}
 	string::size_type pos(catarg.find('/'));
 	if(pos == string::npos) {
-		sqlite_callback_error = true;
 		m_error_callback(eix::format(_("\"%s\" not of the form package/category-version")) % catarg);
-		return;
+		return false;
 	}
 	string name_ver(catarg, pos + 1);
 	catarg.resize(pos);
@@ -224,13 +212,13 @@ void SqliteCache::sqlite_callback_cpp(int argc, const char *const *argv, const c
 	Category *dest_cat;
 	if(unlikely(packagetree == NULLPTR)) {
 		if(cat_name != catarg) {
-			return;
+			return true;
 		}
 		dest_cat = category;
 	} else if(never_add_categories) {
 		dest_cat = packagetree->find(catarg);
 		if(unlikely(dest_cat == NULLPTR)) {
-			return;
+			return true;
 		}
 	} else {
 		dest_cat = &((*packagetree)[catarg]);
@@ -238,7 +226,7 @@ void SqliteCache::sqlite_callback_cpp(int argc, const char *const *argv, const c
 	string curr_name, curr_version;
 	if(unlikely(!ExplodeAtom::split(&curr_name, &curr_version, name_ver.c_str()))) {
 		m_error_callback(eix::format(_("cannot split \"%s\" into package and version")) % name_ver);
-		return;
+		return true;
 	}
 	/* Search for existing package */
 	Package *pkg(dest_cat->findPackage(curr_name));
@@ -270,8 +258,7 @@ void SqliteCache::sqlite_callback_cpp(int argc, const char *const *argv, const c
 			TrueIndex::c_str(argv, &trueindex, TrueIndex::RDEPEND),
 			TrueIndex::c_str(argv, &trueindex, TrueIndex::PDEPEND),
 			TrueIndex::c_str(argv, &trueindex, TrueIndex::BDEPEND),
-			TrueIndex::c_str(argv, &trueindex, TrueIndex::IDEPEND),
-			false);
+			TrueIndex::c_str(argv, &trueindex, TrueIndex::IDEPEND));
 		if(ExtendedVersion::use_src_uri) {
 			version->src_uri = TrueIndex::c_str(argv, &trueindex, TrueIndex::SRC_URI);
 		}
@@ -285,10 +272,27 @@ void SqliteCache::sqlite_callback_cpp(int argc, const char *const *argv, const c
 			pkg->desc     = TrueIndex::c_str(argv, &trueindex, TrueIndex::DESCRIPTION);
 		}
 	}
+	return true;
+#endif
+}
+
+/**
+Append the column name s to sql, quoted as an sqlite identifier
+**/
+ATTRIBUTE_NONNULL_ static void append_column(string *sql, const char *s);
+
+static void append_column(string *sql, const char *s) {
+	sql->append(1, '"');
+	for(; *s != '\0'; ++s) {
+		if(*s == '"') {
+			sql->append(1, '"');
+		}
+		sql->append(1, *s);
+	}
+	sql->append(1, '"');
 }
 
 bool SqliteCache::readCategories(PackageTree *pkgtree, const char *catname, Category *cat) {
-	char *errormessage(NULLPTR);
 	string sqlitefile(m_prefix + PORTAGE_CACHE_PATH + m_scheme);
 	// Cut all trailing '/' and append ".sqlite" to the name
 	string::size_type pos(sqlitefile.find_last_not_of('/'));
@@ -305,20 +309,99 @@ bool SqliteCache::readCategories(PackageTree *pkgtree, const char *catname, Cate
 		m_error_callback(eix::format(_("cannot open cache file %s")) % sqlitefile);
 		return false;
 	}
-	callback_arg = this;
-	sqlite_callback_error = false;
-	maxindex = 0;
-	packagetree = pkgtree;
-	category = cat;
-	cat_name = catname;
-	int rc(sqlite3_exec(db, "select * from portage_packages", sqlite_callback, NULLPTR, &errormessage));
+
+	// Find the columns of the table without reading any data
+	sqlite3_stmt *stmt(NULLPTR);
+	if(unlikely(sqlite3_prepare_v2(db, "select * from portage_packages", -1, &stmt, NULLPTR) != SQLITE_OK)) {
+		m_error_callback(eix::format(_("sqlite error: %s")) % sqlite3_errmsg(db));
+		sqlite3_close(db);
+		return false;
+	}
+	int argc(sqlite3_column_count(stmt));
+	WordVec colnames;
+	colnames.reserve(argc);
+	for(int i(0); likely(i < argc); ++i) {
+		colnames.push_back(welldefine(sqlite3_column_name(stmt, i)));
+	}
+	sqlite3_finalize(stmt);
+	if(unlikely(true_index == NULLPTR)) {
+		true_index = new TrueIndex;
+	}
+	{
+		std::vector<const char *> azColName(argc + 1);
+		for(int i(0); likely(i < argc); ++i) {
+			azColName[i] = colnames[i].c_str();
+		}
+		if(unlikely(!true_index->calc(argc, &(azColName[0]), &trueindex))) {
+			sqlite3_close(db);
+			trueindex.clear();
+			m_error_callback(eix::format(_("sqlite table in %s lacks mandatory columns")) % sqlitefile);
+			return false;
+		}
+	}
+
+	// Select only the columns which we actually store
+	string name_column;
+	append_column(&name_column, colnames[trueindex[TrueIndex::NAME]].c_str());
+	string sql("select ");
+	int columns(0);
+	for(TrueIndexRes i(0); likely(i < TrueIndex::LAST); ++i) {
+		int& t(trueindex[i]);
+		if((t < 0) || !TrueIndex::needed(i)) {
+			t = -1;
+			continue;
+		}
+		if(columns != 0) {
+			sql.append(", ");
+		}
+		append_column(&sql, colnames[t].c_str());
+		t = columns++;
+	}
+	sql.append(" from portage_packages");
+	string cat_from, cat_to;
+	if(pkgtree == NULLPTR) {
+		// Let sqlite filter the category: "cat/" <= key < "cat0"
+		sql.append(" where ");
+		sql.append(name_column);
+		sql.append(" >= ?1 and ");
+		sql.append(name_column);
+		sql.append(" < ?2");
+		cat_from.assign(catname);
+		cat_from.append(1, '/');
+		cat_to.assign(catname);
+		cat_to.append(1, '0');  // the character following '/'
+	}
+	bool ok(sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULLPTR) == SQLITE_OK);
+	if(likely(ok) && (pkgtree == NULLPTR)) {
+		ok = ((sqlite3_bind_text(stmt, 1, cat_from.c_str(), -1, SQLITE_STATIC) == SQLITE_OK) &&
+			(sqlite3_bind_text(stmt, 2, cat_to.c_str(), -1, SQLITE_STATIC) == SQLITE_OK));
+	}
+	if(likely(ok)) {
+		std::vector<const char *> argv(columns);
+		for(;;) {
+			int rc(sqlite3_step(stmt));
+			if(rc != SQLITE_ROW) {
+				ok = (rc == SQLITE_DONE);
+				break;
+			}
+			for(int i(0); likely(i < columns); ++i) {
+				argv[i] = reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
+			}
+			if(unlikely(!add_row(pkgtree, catname, &(argv[0]), cat))) {
+				sqlite3_finalize(stmt);
+				sqlite3_close(db);
+				trueindex.clear();
+				return false;
+			}
+		}
+	}
+	if(unlikely(!ok)) {
+		m_error_callback(eix::format(_("sqlite error: %s")) % sqlite3_errmsg(db));
+	}
+	sqlite3_finalize(stmt);
 	sqlite3_close(db);
 	trueindex.clear();
-	if(rc != SQLITE_OK) {
-		sqlite_callback_error = true;
-		m_error_callback(eix::format(_("sqlite error: %s")) % errormessage);
-	}
-	return !sqlite_callback_error;
+	return ok;
 }
 
 #else  // Not WITH_SQLITE
@@ -23,33 +23,24 @@ class PackageTree;
 class TrueIndex;
 
 class SqliteCache FINAL : public BasicCache {
-		friend int sqlite_callback(void *NotUsed, int argc, char **argv, char **azColName);
-
 	public:  // actually private, but this is too clumsy...
 		typedef std::vector<int> TrueIndexMap;
 
 	private:
 		bool never_add_categories;
-		ATTRIBUTE_NONNULL((4)) void sqlite_callback_cpp(int argc, const char *const *argv, const char *const *azColName);
-		TrueIndexMap trueindex;
-		int maxindex;
-
-		/**
-		This variable is actually the this-parameter for our sqlite_callback function.
-		Note that this makes readCategories non-reentrant.
-		**/
-		static SqliteCache *callback_arg;
 		/**
-		Our sqlite_callback() will set this to true in case of an error
+		The column of the prepared statement for each TrueIndex::Names
+		or a negative value if the data is not selected
 		**/
-		bool sqlite_callback_error;
+		TrueIndexMap trueindex;
+		static TrueIndex *true_index;
+
 		/**
-		Parameter passing to sqlite_callback()
+		Add the version described by the selected columns argv of one row.
+		The parameters packagetree, cat_name, category are as in readCategories.
+		@return false if a fatal error occurred
 		**/
-		PackageTree *packagetree;
-		Category *category;
-		const char *cat_name;
-		static TrueIndex *true_index;
+		ATTRIBUTE_NONNULL((3)) bool add_row(PackageTree *packagetree, const char *cat_name, const char *const *argv, Category *category);
 
 	public:
 		SqliteCache() : BasicCache(), never_add_categories(true) {
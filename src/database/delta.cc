@@ -0,0 +1,497 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/delta.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+
+#include "database/header.h"
+#include "database/io.h"
+#include "eixTk/auto_array.h"
+#include "eixTk/diagnostics.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "portage/depend.h"
+#include "portage/extendedversion.h"
+#include "portage/package.h"
+#include "portage/packagetree.h"
+#include "portage/version.h"
+
+using std::string;
+
+const char DBDelta::magic[] = "eix-delta\n";
+
+/**
+Position of the sequential reading of a database or of a delta section
+**/
+class DBDeltaCursor {
+	public:
+		Database *db;
+		eix::Catsize cats;
+		eix::Treesize pkgs;
+		bool have_category, have_package;
+		string category, name;
+		eix::OffsetType start, len;
+
+		DBDeltaCursor(Database *d, eix::Catsize c) :
+			db(d), cats(c), pkgs(0), have_category(false), have_package(false) {
+		}
+};
+
+ATTRIBUTE_NONNULL_ static bool get_filesize(const char *file, eix::OffsetType *size);
+static void corrupt_delta(const char *deltafile, string *errtext);
+ATTRIBUTE_NONNULL_ static void index_hashes(DBHeader *hdr);
+
+static bool get_filesize(const char *file, eix::OffsetType *size) {
+	struct stat st;
+	if(unlikely(stat(file, &st) != 0)) {
+		return false;
+	}
+	*size = st.st_size;
+	return true;
+}
+
+static void corrupt_delta(const char *deltafile, string *errtext) {
+	*errtext = eix::format(_("delta file %s is corrupt")) % deltafile;
+}
+
+static void index_hashes(DBHeader *hdr) {
+	hdr->eapi_hash.make_index();
+	hdr->license_hash.make_index();
+	hdr->keywords_hash.make_index();
+	hdr->iuse_hash.make_index();
+	hdr->slot_hash.make_index();
+	if(hdr->use_depend) {
+		hdr->depend_hash.make_index();
+	}
+}
+
+bool DBDelta::open_delta(Database *db, const char *deltafile, eix::OffsetType *oldsize, eix::OffsetType *sectionlen, string *errtext) {
+	if(unlikely(!db->openread(deltafile))) {
+		*errtext = eix::format(_("cannot open delta file %s for reading (mode = 'rb')")) % deltafile;
+		return false;
+	}
+	size_t magic_len(std::strlen(magic));
+	eix::auto_array<char> buf(new char[magic_len + 1]);
+	buf.get()[magic_len] = 0;
+	if(unlikely(!db->read_string_plain(buf.get(), magic_len, errtext))) {
+		return false;
+	}
+	if(unlikely(std::strcmp(magic, buf.get()) != 0)) {
+		*errtext = eix::format(_("%s is not an eix delta file")) % deltafile;
+		return false;
+	}
+	DeltaVersion version;
+	if(unlikely(!db->read_num(&version, errtext))) {
+		return false;
+	}
+	if(unlikely(version != current)) {
+		*errtext = eix::format(_("delta file %s uses format %s (current is %s)"))
+			% deltafile % version % current;
+		return false;
+	}
+	return (likely(db->read_num(oldsize, errtext)) &&
+		likely(db->read_num(sectionlen, errtext)));
+}
+
+/**
+Append the raw data from start to the current position to header
+**/
+bool DBDelta::copy_header(Database *db, eix::OffsetType start, string *header, string *errtext) {
+	eix::OffsetType end(db->tell());
+GCC_DIAG_OFF(sign-conversion)
+	string::size_type len(end - start);
+GCC_DIAG_ON(sign-conversion)
+	eix::auto_array<char> buf(new char[len + 1]);
+	if(unlikely(!(db->seekabs(start, errtext) &&
+		db->read_string_plain(buf.get(), len, errtext)))) {
+		return false;
+	}
+	header->append(buf.get(), len);
+	return true;
+}
+
+bool DBDelta::next_category(DBDeltaCursor *c, string *errtext) {
+	c->have_package = false;
+	if(c->cats == 0) {
+		c->have_category = false;
+		return true;
+	}
+	--(c->cats);
+	c->have_category = true;
+	return c->db->read_category_header(&(c->category), &(c->pkgs), errtext);
+}
+
+/**
+Read length and name of the next package of the category and
+seek back to the beginning of its record
+**/
+bool DBDelta::next_package(DBDeltaCursor *c, string *errtext) {
+	if(c->pkgs == 0) {
+		c->have_package = false;
+		return true;
+	}
+	--(c->pkgs);
+	c->have_package = true;
+	Database *db(c->db);
+	if(unlikely(!db->read_num(&(c->len), errtext))) {
+		return false;
+	}
+	c->start = db->tell();
+	return (likely(db->read_string(&(c->name), errtext)) &&
+		likely(db->seekabs(c->start, errtext)));
+}
+
+bool DBDelta::skip_package(DBDeltaCursor *c, string *errtext) {
+	return (likely(c->db->seekabs(c->start + c->len, errtext)) &&
+		likely(next_package(c, errtext)));
+}
+
+/**
+Copy the record of the current package (with its length) to dest
+**/
+bool DBDelta::copy_package(DBDeltaCursor *c, Database *dest, string *errtext) {
+GCC_DIAG_OFF(sign-conversion)
+	string::size_type len(c->len);
+GCC_DIAG_ON(sign-conversion)
+	eix::auto_array<char> buf(new char[len + 1]);
+	if(unlikely(!c->db->read_string_plain(buf.get(), len, errtext))) {
+		return false;
+	}
+	return (likely(dest->write_num(c->len, errtext)) &&
+		likely(dest->write_string_plain(string(buf.get(), len), errtext)) &&
+		likely(next_package(c, errtext)));
+}
+
+bool DBDelta::write_delta(const char *deltafile, const char *oldfile, const PackageTree& tree, const DBHeader& hdr, string *errtext) {
+	Database olddb;
+	eix::OffsetType oldsize;
+	if(unlikely(!(get_filesize(oldfile, &oldsize) && olddb.openread(oldfile)))) {
+		*errtext = eix::format(_("cannot open database file %s for reading (mode = 'rb')")) % oldfile;
+		return false;
+	}
+	DBHeader oldhdr;
+	if(unlikely(!olddb.read_header(&oldhdr, errtext, DBHeader::current))) {
+		return false;
+	}
+
+	// The old section starts with the unmodified header of the old database,
+	// the new section with the header of the new database.
+	string oldsection, newsection;
+	if(unlikely(!copy_header(&olddb, 0, &oldsection, errtext))) {
+		return false;
+	}
+	Database out;
+	out.write_to_string(&newsection);
+	if(unlikely(!out.write_header(hdr, errtext))) {
+		return false;
+	}
+
+	DBDeltaCursor oldc(&olddb, oldhdr.size);
+	if(unlikely(!next_category(&oldc, errtext))) {
+		return false;
+	}
+	for(PackageTree::const_iterator c(tree.begin()); ; ) {
+		bool have_new(c != tree.end());
+		if(!(oldc.have_category || have_new)) {
+			break;
+		}
+		int catcmp((!oldc.have_category) ? 1 :
+			((!have_new) ? -1 : oldc.category.compare(c->first)));
+		bool use_old(catcmp <= 0);
+		const Category *newcat((catcmp >= 0) ? c->second : NULLPTR);
+		Category::const_iterator p;
+		if(newcat != NULLPTR) {
+			p = newcat->begin();
+		}
+		if(use_old) {
+			if(unlikely(!next_package(&oldc, errtext))) {
+				return false;
+			}
+		}
+		string oldrecords, newrecords;
+		eix::Treesize oldcount(0), newcount(0);
+		for(;;) {
+			bool have_old(use_old && oldc.have_package);
+			bool have_pkg((newcat != NULLPTR) && (p != newcat->end()));
+			if(!(have_old || have_pkg)) {
+				break;
+			}
+			int cmp((!have_old) ? 1 :
+				((!have_pkg) ? -1 : oldc.name.compare((*p)->name)));
+			if(cmp > 0) {  // inserted
+				out.write_to_string(&newrecords);
+				if(unlikely(!out.write_package(**p, hdr, errtext))) {
+					return false;
+				}
+				++newcount;
+				++p;
+				continue;
+			}
+			if(cmp == 0) {
+				string record;
+				out.write_to_string(&record);
+				if(unlikely(!out.write_package(**p, hdr, errtext))) {
+					return false;
+				}
+				++p;
+				// The package is unchanged if its old record (transcoded to
+				// the hashes of the new header) is identical to the new one.
+				// Transcoding fails if some string is not hashed anymore.
+				Package pkg;
+				if(unlikely(!olddb.read_package_pure(&pkg, oldhdr, errtext))) {
+					return false;
+				}
+				string transcoded;
+				out.write_to_string(&transcoded);
+				if(out.write_package(pkg, hdr, NULLPTR) && (transcoded == record)) {
+					if(unlikely(!skip_package(&oldc, errtext))) {
+						return false;
+					}
+					continue;
+				}
+				if(unlikely(!olddb.seekabs(oldc.start, errtext))) {
+					return false;
+				}
+				newrecords.append(record);
+				++newcount;
+			}
+			// removed or replaced
+			out.write_to_string(&oldrecords);
+			if(unlikely(!copy_package(&oldc, &out, errtext))) {
+				return false;
+			}
+			++oldcount;
+		}
+		if(use_old) {
+			out.write_to_string(&oldsection);
+			if(unlikely(!out.write_category_header(oldc.category, oldcount, errtext))) {
+				return false;
+			}
+			oldsection.append(oldrecords);
+			if(unlikely(!next_category(&oldc, errtext))) {
+				return false;
+			}
+		}
+		if(newcat != NULLPTR) {
+			out.write_to_string(&newsection);
+			if(unlikely(!out.write_category_header(c->first, newcount, errtext))) {
+				return false;
+			}
+			newsection.append(newrecords);
+			++c;
+		}
+	}
+	out.write_to_string(NULLPTR);
+
+	Database delta;
+	if(unlikely(!delta.openwrite(deltafile))) {
+		*errtext = eix::format(_("cannot open delta file %s for writing (mode = 'wb')")) % deltafile;
+		return false;
+	}
+	if(likely(delta.write_string_plain(magic, errtext) &&
+		delta.write_num(current, errtext) &&
+		delta.write_num(oldsize, errtext) &&
+		delta.write_num(oldsection.size(), errtext) &&
+		delta.write_string_plain(oldsection, errtext) &&
+		delta.write_string_plain(newsection, errtext))) {
+		return true;
+	}
+	delta.destroy();
+	std::remove(deltafile);
+	return false;
+}
+
+bool DBDelta::apply_delta(const char *newfile, const char *oldfile, const char *deltafile, string *errtext) {
+	string tmpfile(newfile);
+	tmpfile.append(".tmp");
+	Database out;
+	if(unlikely(!out.openwrite(tmpfile.c_str()))) {
+		*errtext = eix::format(_("cannot open database file %s for writing (mode = 'wb')")) % tmpfile;
+		return false;
+	}
+	bool ok(apply_to(&out, oldfile, deltafile, errtext));
+	out.destroy();
+	if(likely(ok)) {
+		if(likely(std::rename(tmpfile.c_str(), newfile) == 0)) {
+			return true;
+		}
+		*errtext = eix::format(_("cannot rename %s to %s")) % tmpfile % newfile;
+	}
+	std::remove(tmpfile.c_str());
+	return false;
+}
+
+bool DBDelta::apply_to(Database *dest, const char *oldfile, const char *deltafile, string *errtext) {
+	// We must read all hashes, in particular the depend hash
+	Depend::use_depend = true;
+
+	eix::OffsetType oldsize, sectionlen;
+	Database removed;
+	if(unlikely(!open_delta(&removed, deltafile, &oldsize, &sectionlen, errtext))) {
+		return false;
+	}
+	eix::OffsetType start(removed.tell());
+	DBHeader removedhdr;
+	string removedheader;
+	if(unlikely(!(removed.read_header(&removedhdr, errtext, DBHeader::current) &&
+		copy_header(&removed, start, &removedheader, errtext)))) {
+		return false;
+	}
+
+	Database inserted;
+	if(unlikely(!(open_delta(&inserted, deltafile, &oldsize, &sectionlen, errtext) &&
+		inserted.seekrel(sectionlen, errtext)))) {
+		return false;
+	}
+	start = inserted.tell();
+	DBHeader hdr;
+	string header;
+	if(unlikely(!(inserted.read_header(&hdr, errtext, DBHeader::current) &&
+		copy_header(&inserted, start, &header, errtext)))) {
+		return false;
+	}
+
+	Database olddb;
+	if(unlikely(!olddb.openread(oldfile))) {
+		*errtext = eix::format(_("cannot open database file %s for reading (mode = 'rb')")) % oldfile;
+		return false;
+	}
+	DBHeader oldhdr;
+	string oldheader;
+	if(unlikely(!(olddb.read_header(&oldhdr, errtext, DBHeader::current) &&
+		copy_header(&olddb, 0, &oldheader, errtext)))) {
+		return false;
+	}
+	eix::OffsetType size;
+	if(unlikely(!get_filesize(oldfile, &size) || (size != oldsize) ||
+		(oldheader != removedheader))) {
+		*errtext = eix::format(_("delta file %s does not match database %s")) % deltafile % oldfile;
+		return false;
+	}
+
+	// Unchanged packages are transcoded with the settings of the new database
+	Depend::use_depend = hdr.use_depend;
+	Version::use_required_use = hdr.use_required_use;
+	ExtendedVersion::use_src_uri = hdr.use_src_uri;
+	index_hashes(&hdr);
+
+	if(unlikely(!dest->write_string_plain(header, errtext))) {
+		return false;
+	}
+	DBDeltaCursor oldc(&olddb, oldhdr.size);
+	DBDeltaCursor remc(&removed, removedhdr.size);
+	DBDeltaCursor insc(&inserted, hdr.size);
+	if(unlikely(!(next_category(&oldc, errtext) &&
+		next_category(&remc, errtext) &&
+		next_category(&insc, errtext)))) {
+		return false;
+	}
+	for(; likely(insc.have_category); ) {
+		// The categories of the old database and its section are identical
+		if(unlikely((oldc.have_category != remc.have_category) ||
+			(oldc.have_category && (oldc.category != remc.category)))) {
+			corrupt_delta(deltafile, errtext);
+			return false;
+		}
+		int catcmp(oldc.have_category ? oldc.category.compare(insc.category) : 1);
+		bool use_old(catcmp <= 0);
+		eix::Treesize total(0);
+		if(use_old) {
+			if(unlikely(remc.pkgs > oldc.pkgs)) {
+				corrupt_delta(deltafile, errtext);
+				return false;
+			}
+			total = oldc.pkgs - remc.pkgs;
+			if(unlikely(!(next_package(&oldc, errtext) &&
+				next_package(&remc, errtext)))) {
+				return false;
+			}
+		}
+		if(catcmp >= 0) {
+			total += insc.pkgs;
+			if(unlikely(!(dest->write_category_header(insc.category, total, errtext) &&
+				next_package(&insc, errtext)))) {
+				return false;
+			}
+		}
+		for(;;) {
+			// Skip removed or replaced packages
+			while(use_old && oldc.have_package && remc.have_package &&
+				(oldc.name == remc.name)) {
+				if(unlikely(!(skip_package(&oldc, errtext) &&
+					skip_package(&remc, errtext)))) {
+					return false;
+				}
+			}
+			bool have_old(use_old && oldc.have_package);
+			if(!(have_old || insc.have_package)) {
+				break;
+			}
+			if(unlikely(total-- == 0)) {
+				corrupt_delta(deltafile, errtext);
+				return false;
+			}
+			int cmp((!have_old) ? 1 :
+				((!insc.have_package) ? -1 : oldc.name.compare(insc.name)));
+			if(cmp > 0) {
+				if(unlikely(!copy_package(&insc, dest, errtext))) {
+					return false;
+				}
+				continue;
+			}
+			if(unlikely(cmp == 0)) {
+				corrupt_delta(deltafile, errtext);
+				return false;
+			}
+			Package pkg;
+			if(unlikely(!(olddb.read_package_pure(&pkg, oldhdr, errtext) &&
+				dest->write_package(pkg, hdr, errtext) &&
+				skip_package(&oldc, errtext)))) {
+				return false;
+			}
+		}
+		if(unlikely(remc.have_package || (total != 0))) {
+			corrupt_delta(deltafile, errtext);
+			return false;
+		}
+		if(use_old) {
+			if(unlikely(!(next_category(&oldc, errtext) &&
+				next_category(&remc, errtext)))) {
+				return false;
+			}
+		}
+		if(catcmp >= 0) {
+			if(unlikely(!next_category(&insc, errtext))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool DBDelta::open_section(Database *db, DBHeader *hdr, const char *deltafile, bool new_section, string *errtext) {
+	eix::OffsetType oldsize, sectionlen;
+	if(unlikely(!open_delta(db, deltafile, &oldsize, &sectionlen, errtext))) {
+		return false;
+	}
+	if(new_section) {
+		if(unlikely(!db->seekrel(sectionlen, errtext))) {
+			return false;
+		}
+	}
+	return db->read_header(hdr, errtext, DBHeader::current);
+}
@@ -0,0 +1,73 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_DELTA_H_
+#define SRC_DATABASE_DELTA_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+
+class Database;
+class DBDeltaCursor;
+class DBHeader;
+class PackageTree;
+
+/**
+A binary delta between two databases of the current format.
+The delta consists of two sections: The first contains the records of the
+removed or replaced packages of the old database, the second those of the
+inserted or replaced packages of the new database.
+Each section is a database of its own which has the header of the
+corresponding full database but lacks the unchanged packages.
+**/
+class DBDelta {
+	public:
+		typedef eix::UNumber DeltaVersion;
+
+		static const char magic[];
+
+		/**
+		Current version of the delta format
+		**/
+		static CONSTEXPR const DeltaVersion current = 1;
+
+		/**
+		Write the delta from the database oldfile to tree (with header hdr)
+		**/
+		ATTRIBUTE_NONNULL_ static bool write_delta(const char *deltafile, const char *oldfile, const PackageTree& tree, const DBHeader& hdr, std::string *errtext);
+
+		/**
+		Apply deltafile to the database oldfile, streaming the result to
+		a temporary file which is finally renamed to newfile.
+		In particular, newfile may be oldfile.
+		This sets Depend::use_depend, Version::use_required_use, and
+		ExtendedVersion::use_src_uri according to the new database.
+		**/
+		ATTRIBUTE_NONNULL_ static bool apply_delta(const char *newfile, const char *oldfile, const char *deltafile, std::string *errtext);
+
+		/**
+		Open deltafile and read the header of its old (or new) section,
+		so that a PackageReader can iterate over the packages of this section
+		**/
+		ATTRIBUTE_NONNULL_ static bool open_section(Database *db, DBHeader *hdr, const char *deltafile, bool new_section, std::string *errtext);
+
+	private:
+		ATTRIBUTE_NONNULL_ static bool open_delta(Database *db, const char *deltafile, eix::OffsetType *oldsize, eix::OffsetType *sectionlen, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool copy_header(Database *db, eix::OffsetType start, std::string *header, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool next_category(DBDeltaCursor *c, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool next_package(DBDeltaCursor *c, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool skip_package(DBDeltaCursor *c, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool copy_package(DBDeltaCursor *c, Database *dest, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool apply_to(Database *dest, const char *oldfile, const char *deltafile, std::string *errtext);
+};
+
+#endif  // SRC_DATABASE_DELTA_H_
@@ -0,0 +1,222 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/fuzzy.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "database/io.h"
+#include "database/trigram.h"
+#include "eixTk/auto_array.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "portage/package.h"
+#include "portage/packagetree.h"
+#include "search/levenshtein.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+const char FuzzyIndex::magic[] = "eix-fuzzy\n";
+const char FuzzyIndex::suffix[] = ".fuzzy";
+
+typedef map<string, vector<eix::Treesize> > NamePackages;
+
+/**
+A node of the BK-tree while the index is written
+**/
+class BKNode {
+	public:
+		typedef vector<BKNode>::size_type Index;
+		typedef map<Levenshtein, Index> Children;
+
+		NamePackages::const_iterator entry;
+		Children children;
+
+		explicit BKNode(NamePackages::const_iterator e) : entry(e) {
+		}
+};
+
+typedef vector<BKNode> BKTree;
+
+ATTRIBUTE_NONNULL_ static void bk_insert(BKTree *tree, NamePackages::const_iterator entry);
+
+static void bk_insert(BKTree *tree, NamePackages::const_iterator entry) {
+	BKNode::Index i(0);
+	if(unlikely(tree->empty())) {
+		tree->PUSH_BACK(BKNode(entry));
+		return;
+	}
+	for(;;) {
+		Levenshtein d(get_levenshtein_distance(entry->first.c_str(), (*tree)[i].entry->first.c_str()));
+		BKNode::Children& children((*tree)[i].children);
+		BKNode::Children::const_iterator it(children.find(d));
+		if(it == children.end()) {
+			children[d] = tree->size();
+			tree->PUSH_BACK(BKNode(entry));
+			return;
+		}
+		i = it->second;
+	}
+}
+
+bool FuzzyIndex::write_index(const char *indexfile, const char *dbfile, const PackageTree& tree, string *errtext) {
+	eix::OffsetType dbsize;
+	eix::UNumber dbmtime, dbgeneration;
+	if(unlikely(!TrigramIndex::dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration))) {
+		*errtext = eix::format(_("cannot stat database file %s")) % dbfile;
+		return false;
+	}
+	NamePackages names;
+	eix::Treesize n(0);
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		Category *ci(c->second);
+		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p, ++n) {
+			names[p->name].PUSH_BACK(n);
+		}
+	}
+	BKTree bktree;
+	bktree.reserve(names.size());
+	for(NamePackages::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		bk_insert(&bktree, it);
+	}
+
+	// Children are inserted after their parents. Hence, writing the nodes
+	// in reverse order, the offsets of the children are known for a node.
+	Database out;
+	string data;
+	vector<eix::OffsetType> offsets(bktree.size());
+	out.write_to_string(&data);
+	for(BKNode::Index i(bktree.size()); likely(i != 0); ) {
+		const BKNode& node(bktree[--i]);
+		offsets[i] = data.size();
+		out.write_string(node.entry->first, NULLPTR);
+		out.write_num(node.entry->second.size(), NULLPTR);
+		eix::Treesize prev(0);
+		for(vector<eix::Treesize>::const_iterator p(node.entry->second.begin());
+			likely(p != node.entry->second.end()); ++p) {
+			out.write_num(*p - prev, NULLPTR);
+			prev = *p;
+		}
+		out.write_num(node.children.size(), NULLPTR);
+		for(BKNode::Children::const_iterator it(node.children.begin());
+			likely(it != node.children.end()); ++it) {
+			out.write_num(it->first, NULLPTR);
+			out.write_num(offsets[it->second], NULLPTR);
+		}
+	}
+	out.write_to_string(NULLPTR);
+	eix::OffsetType root(offsets.empty() ? 0 : offsets[0]);
+
+	if(unlikely(!out.openwrite(indexfile))) {
+		*errtext = eix::format(_("cannot open fuzzy index %s for writing (mode = 'wb')")) % indexfile;
+		return false;
+	}
+	if(likely(out.write_string_plain(magic, errtext) &&
+		out.write_num(current, errtext) &&
+		out.write_num(dbsize, errtext) &&
+		out.write_num(dbmtime, errtext) &&
+		out.write_num(dbgeneration, errtext) &&
+		out.write_num(n, errtext) &&
+		out.write_num(bktree.size(), errtext) &&
+		out.write_num(root, errtext) &&
+		out.write_string_plain(data, errtext))) {
+		return true;
+	}
+	out.destroy();
+	std::remove(indexfile);
+	return false;
+}
+
+bool FuzzyIndex::open(const char *indexfile, const char *dbfile) {
+	eix::OffsetType dbsize, size;
+	eix::UNumber dbmtime, mtime, dbgeneration, generation;
+	if(!TrigramIndex::dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration) || !db.openread(indexfile)) {
+		return false;
+	}
+	size_t magic_len(std::strlen(magic));
+	eix::auto_array<char> buf(new char[magic_len + 1]);
+	buf.get()[magic_len] = 0;
+	IndexVersion version;
+	if(unlikely(!db.read_string_plain(buf.get(), magic_len, NULLPTR) ||
+		(std::strcmp(magic, buf.get()) != 0) ||
+		!db.read_num(&version, NULLPTR) || (version != current) ||
+		!db.read_num(&size, NULLPTR) || (size != dbsize) ||
+		!db.read_num(&mtime, NULLPTR) || (mtime != dbmtime) ||
+		!db.read_num(&generation, NULLPTR) || (generation != dbgeneration) ||
+		!db.read_num(&packages, NULLPTR) ||
+		!db.read_num(&nodes, NULLPTR) ||
+		!db.read_num(&root, NULLPTR))) {
+		db.destroy();
+		return false;
+	}
+	start = db.tell();
+	return true;
+}
+
+/**
+Only the visited nodes are read from the file
+**/
+bool FuzzyIndex::lookup(PackageSet *set, const string& name, Levenshtein max) {
+	set->assign(packages, false);
+	if(unlikely(nodes == 0)) {
+		return true;
+	}
+	vector<eix::OffsetType> todo(1, root);
+	string node_name;
+	while(likely(!todo.empty())) {
+		eix::OffsetType offset(todo.back());
+		todo.pop_back();
+		if(unlikely(!db.seekabs(start + offset, NULLPTR) ||
+			!db.read_string(&node_name, NULLPTR))) {
+			return false;
+		}
+		Levenshtein d(get_levenshtein_distance(name.c_str(), node_name.c_str()));
+		eix::Treesize count;
+		if(unlikely(!db.read_num(&count, NULLPTR))) {
+			return false;
+		}
+		eix::Treesize n(0);
+		for(; likely(count != 0); --count) {
+			eix::Treesize diff;
+			if(unlikely(!db.read_num(&diff, NULLPTR))) {
+				return false;
+			}
+			n += diff;
+			if((d <= max) && likely(n < packages)) {
+				(*set)[n] = true;
+			}
+		}
+		vector<eix::OffsetType>::size_type children;
+		if(unlikely(!db.read_num(&children, NULLPTR))) {
+			return false;
+		}
+		for(; likely(children != 0); --children) {
+			Levenshtein e;
+			eix::OffsetType child;
+			if(unlikely(!db.read_num(&e, NULLPTR) ||
+				!db.read_num(&child, NULLPTR))) {
+				return false;
+			}
+			// By the triangle inequality, only |e - d| <= max can match
+			if((e + max >= d) && (e <= d + max)) {
+				todo.PUSH_BACK(child);
+			}
+		}
+	}
+	return true;
+}
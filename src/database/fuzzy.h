@@ -0,0 +1,82 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_FUZZY_H_
+#define SRC_DATABASE_FUZZY_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "database/io.h"
+#include "database/trigram.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "search/levenshtein.h"
+
+class PackageTree;
+
+/**
+A BK-tree of the package names of a database:
+Each node holds a name and the packages with this name; the subtree of
+a node reached by an edge labeled d contains only names with
+Levenshtein distance d from the name of the node.
+Hence, the names within distance k of some string are found by
+following only the edges with labels which differ by at most k from the
+distance of the string to the name of the node.
+Packages are identified by their position in the database.
+**/
+class FuzzyIndex {
+	public:
+		typedef eix::UNumber IndexVersion;
+		typedef TrigramIndex::PackageSet PackageSet;
+
+		static const char magic[];
+		static const char suffix[];
+
+		/**
+		Current version of the index format
+		**/
+		static CONSTEXPR const IndexVersion current = 2;
+
+		FuzzyIndex() : packages(0), nodes(0), root(0), start(0) {
+		}
+
+		/**
+		Write the index for tree to indexfile.
+		The database dbfile must already have been written completely.
+		**/
+		ATTRIBUTE_NONNULL_ static bool write_index(const char *indexfile, const char *dbfile, const PackageTree& tree, std::string *errtext);
+
+		/**
+		Open indexfile and read its header.
+		@return false if the index is missing or does not belong to dbfile
+		**/
+		ATTRIBUTE_NONNULL_ bool open(const char *indexfile, const char *dbfile);
+
+		/**
+		Set *set to the packages whose name has Levenshtein distance at
+		most max from name.
+		@return false if the index cannot restrict the packages
+		**/
+		ATTRIBUTE_NONNULL_ bool lookup(PackageSet *set, const std::string& name, Levenshtein max);
+
+		/**
+		@return number of packages in the indexed database
+		**/
+		eix::Treesize size() const {
+			return packages;
+		}
+
+	private:
+		Database db;
+		eix::Treesize packages, nodes;
+		eix::OffsetType root, start;
+};
+
+#endif  // SRC_DATABASE_FUZZY_H_
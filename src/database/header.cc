@@ -18,6 +18,7 @@
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringutils.h"
+#include "portage/depend.h"
 #include "portage/extendedversion.h"
 
 using std::set;
@@ -48,12 +49,27 @@ practically sure the first match should be it; if not, the second.
 The remainder is meant for museum systems.)
 **/
 const DBHeader::DBVersion DBHeader::accept[] = {
-	DBHeader::current, 38, 37, 36, 35, 34, 33, 32, 31,
+	DBHeader::current, 39, 38, 37, 36, 35, 34, 33, 32, 31,
 	0
 };
 
 const char DBHeader::magic[] = "eix\n";
 
+/**
+The words are interned only when they are needed
+**/
+Depend::Token DBHeader::depend_token(StringHash::size_type i) const {
+	if(unlikely(depend_tokens.size() != depend_hash.size())) {
+		depend_tokens.assign(depend_hash.size(), 0);
+	}
+	const string& word(depend_hash[i]);
+	Depend::Token& token(depend_tokens[i]);
+	if(unlikely(token == 0)) {
+		token = Depend::intern(word) + 1;
+	}
+	return token - 1;
+}
+
 /**
 Get overlay for key from table
 **/
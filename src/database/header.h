@@ -20,6 +20,7 @@
 #include "eixTk/eixint.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "portage/depend.h"
 #include "portage/extendedversion.h"
 #include "portage/overlay.h"
 
@@ -37,6 +38,13 @@ class DBHeader {
 		**/
 		OverlayVec overlays;
 
+		/**
+		Tokens of the words of depend_hash, increased by 1;
+		0 means that the word was not interned yet.
+		mutable: it is just a cache
+		**/
+		mutable Depend::Tokens depend_tokens;
+
 	public:
 		StringHash
 			eapi_hash,
@@ -55,6 +63,18 @@ class DBHeader {
 
 		bool use_depend, use_required_use, use_src_uri;
 
+		/**
+		@return the Depend::Token of the word with index i of depend_hash
+		**/
+		Depend::Token depend_token(StringHash::size_type i) const;
+
+		/**
+		Must be called when depend_hash is changed
+		**/
+		void clear_depend_tokens() {
+			depend_tokens.clear();
+		}
+
 		WordVec world_sets;
 
 		typedef  eix::UNumber DBVersion;
@@ -75,7 +95,7 @@ class DBHeader {
 		/**
 		Current version of database-format and what we accept
 		**/
-		static CONSTEXPR const DBVersion current = 39;
+		static CONSTEXPR const DBVersion current = 40;
 		static const DBHeader::DBVersion accept[];
 
 		/**
@@ -87,6 +107,15 @@ class DBHeader {
 		**/
 		eix::Catsize size;
 
+		/**
+		Increased with each database written by eix-update, so that
+		indices can recognize a changed database (0 before version 40)
+		**/
+		eix::UNumber generation;
+
+		DBHeader() : generation(0) {
+		}
+
 		/**
 		Get overlay for key from table
 		**/
@@ -64,6 +64,7 @@ void File::destroy() {
 #endif
 #endif
 	std::fclose(fp);
+	fp = NULLPTR;
 }
 
 bool File::seek(eix::OffsetType offset, int whence, string *errtext) {
@@ -119,6 +120,12 @@ void File::writeError(string *errtext) {
 	}
 }
 
+void File::hashError(string *errtext) {
+	if(errtext != NULLPTR) {
+		*errtext = _("string to be written is missing in database hash");
+	}
+}
+
 bool Database::readUChar(eix::UChar *c, string *errtext) {
 	int ch(getch());
 	if(likely(ch != EOF)) {
@@ -157,7 +164,7 @@ bool Database::read_string(string *s, string *errtext) {
 	eix::auto_array<char> buf(new char[len + 1]);
 	buf.get()[len] = 0;
 	if(likely(read_string_plain(buf.get(), len, errtext))) {
-		*s = buf.get();
+		s->assign(buf.get(), len);
 		return true;
 	}
 	return false;
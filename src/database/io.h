@@ -23,6 +23,7 @@
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "portage/depend.h"
 
 // check_includes: include "portage/basicversion.h"
 
@@ -32,7 +33,6 @@ class Package;
 class PackageReader;
 class PackageTree;
 class PortageSettings;
-class Depend;
 class Version;
 
 #define MAGICNUMCHAR 0xFFU
@@ -40,13 +40,14 @@ class Version;
 class File {
 	private:
 		FILE *fp;
+		std::string *membuf;
 		bool seek(eix::OffsetType offset, int whence, std::string *errtext);
 
 		File(const File& s) ASSIGN_DELETE;
 		File& operator=(const File& s) ASSIGN_DELETE;
 
 	public:
-		File() : fp(NULLPTR) {
+		File() : fp(NULLPTR), membuf(NULLPTR) {
 		}
 
 		~File() {
@@ -54,14 +55,17 @@ class File {
 		}
 
 #ifdef HAVE_MOVE
-		File(File&& s) NOEXCEPT : fp(s.fp) {
+		File(File&& s) NOEXCEPT : fp(s.fp), membuf(s.membuf) {
 			s.fp = NULLPTR;
+			s.membuf = NULLPTR;
 		}
 
 		File& operator=(File&& s) NOEXCEPT {
 			destroy();
 			fp = s.fp;
+			membuf = s.membuf;
 			s.fp = NULLPTR;
+			s.membuf = NULLPTR;
 			return *this;
 		}
 #endif
@@ -70,11 +74,23 @@ class File {
 		ATTRIBUTE_NONNULL_ bool openread(const char *name);
 		ATTRIBUTE_NONNULL_ bool openwrite(const char *name);
 
+		/**
+		Append all subsequent output to s instead of writing it to the file.
+		Pass NULLPTR to write to the file again.
+		**/
+		void write_to_string(std::string *s) {
+			membuf = s;
+		}
+
 		int getch() {
 			return std::fgetc(fp);
 		}
 
 		bool putch(eix::UChar c) {
+			if(unlikely(membuf != NULLPTR)) {
+				membuf->append(1, static_cast<char>(c));
+				return true;
+			}
 			return (std::fputc(c, fp) != EOF);
 		}
 
@@ -83,6 +99,10 @@ class File {
 		}
 
 		bool write(const std::string str) {
+			if(unlikely(membuf != NULLPTR)) {
+				membuf->append(str);
+				return true;
+			}
 			return (std::fwrite(static_cast<const void *>(str.c_str()), sizeof(*(str.c_str())), str.size(), fp) == str.size());
 		}
 
@@ -101,10 +121,16 @@ class File {
 
 		void readError(std::string *errtext);
 		static void writeError(std::string *errtext);
+		static void hashError(std::string *errtext);
 };
 
 class Database : public File {
+		friend class DBDelta;
+		friend class FuzzyIndex;
 		friend class PackageReader;
+		friend class ReverseDependIndex;
+		friend class StabilityIndex;
+		friend class TrigramIndex;
 
 	private:
 		bool counting;
@@ -133,7 +159,12 @@ class Database : public File {
 		bool write_string(const std::string& str, std::string *errtext);
 
 		bool write_hash_string(const StringHash& hash, const std::string& s, std::string *errtext) {
-			return write_num(hash.get_index(s), errtext);
+			StringHash::size_type i;
+			if(likely(hash.find_index(s, &i))) {
+				return write_num(i, errtext);
+			}
+			hashError(errtext);
+			return false;
 		}
 
 		ATTRIBUTE_NONNULL((3)) bool read_hash_string(const StringHash& hash, std::string *s, std::string *errtext) {
@@ -162,12 +193,17 @@ class Database : public File {
 		ATTRIBUTE_NONNULL((2)) bool read_version(Version *v, const DBHeader& hdr, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool write_version(const Version *v, const DBHeader& hdr, std::string *errtext);
 
+		ATTRIBUTE_NONNULL((3)) bool read_depend_tokens(const DBHeader& hdr, Depend::Tokens *tokens, std::string *errtext);
+		bool write_depend_tokens(const DBHeader& hdr, const Depend::Tokens& tokens, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static void hash_depend_tokens(StringHash *hash, const Depend::Tokens& tokens);
+
 		ATTRIBUTE_NONNULL((2)) bool read_depend(Depend *dep, const DBHeader& hdr, std::string *errtext);
 		bool write_depend(const Depend& dep, const DBHeader& hdr, std::string *errtext);
 
 		ATTRIBUTE_NONNULL((2, 3)) bool read_category_header(std::string *name, eix::Treesize *h, std::string *errtext);
 		bool write_category_header(const std::string& name, eix::Treesize size, std::string *errtext);
 
+		ATTRIBUTE_NONNULL((2)) bool read_package_pure(Package *pkg, const DBHeader& hdr, std::string *errtext);
 		bool write_package(const Package& pkg, const DBHeader& hdr, std::string *errtext);
 		bool write_package_pure(const Package& pkg, const DBHeader& hdr, std::string *errtext);
 
@@ -183,6 +219,12 @@ class Database : public File {
 		bool write_header(const DBHeader& hdr, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool read_header(DBHeader *hdr, std::string *errtext, DBHeader::DBVersion minver);
 
+		/**
+		Read only the beginning of the header of dbfile up to the generation
+		@return false if dbfile cannot be read or has a format without generation
+		**/
+		ATTRIBUTE_NONNULL_ static bool read_generation(const char *dbfile, eix::UNumber *generation);
+
 		bool write_packagetree(const PackageTree& pkg, const DBHeader& hdr, std::string *errtext);
 #if 0
 		ATTRIBUTE_NONNULL((2, 4)) bool read_packagetree(PackageTree *tree, const DBHeader& hdr, PortageSettings *ps, std::string *errtext);
@@ -68,6 +68,13 @@ GCC_DIAG_ON(sign-conversion)
 	if(unlikely(!read_num(&(hdr->size), errtext))) {
 		return false;
 	}
+	if(likely(hdr->version >= 40)) {
+		if(unlikely(!read_num(&(hdr->generation), errtext))) {
+			return false;
+		}
+	} else {
+		hdr->generation = 0;
+	}
 
 	ExtendedVersion::Overlay overlay_sz;
 	if(unlikely(!read_num(&(overlay_sz), errtext))) {
@@ -130,6 +137,7 @@ GCC_DIAG_ON(sign-conversion)
 			if(unlikely(!read_hash(&(hdr->depend_hash), errtext))) {
 				return false;
 			}
+			hdr->clear_depend_tokens();
 		} else if(len != 0) {
 			if(unlikely(!seekrel(len, errtext))) {
 				return false;
@@ -139,6 +147,23 @@ GCC_DIAG_ON(sign-conversion)
 	return true;
 }
 
+bool Database::read_generation(const char *dbfile, eix::UNumber *generation) {
+	Database db;
+	if(unlikely(!db.openread(dbfile))) {
+		return false;
+	}
+	size_t magic_len(std::strlen(DBHeader::magic));
+	eix::auto_array<char> buf(new char[magic_len + 1]);
+	buf.get()[magic_len] = 0;
+	DBHeader::DBVersion version;
+	eix::Catsize size;
+	return (db.read_string_plain(buf.get(), magic_len, NULLPTR) &&
+		(std::strcmp(DBHeader::magic, buf.get()) == 0) &&
+		db.read_num(&version, NULLPTR) && (version >= 40) &&
+		db.read_num(&size, NULLPTR) &&
+		db.read_num(generation, NULLPTR));
+}
+
 bool Database::read_hash(StringHash *hash, string *errtext) {
 	hash->init(false);
 	StringHash::size_type i;
@@ -71,13 +71,16 @@ bool Database::read_iuse(const StringHash& hash, IUseSet *iuse, string *errtext)
 	if(unlikely(!read_num(&e, errtext))) {
 		return false;
 	}
+	IUseSet::IUseStd iuse_std;
+	iuse_std.reserve(e);
 	for(; e; --e) {
-		string s;
-		if(unlikely(!read_hash_string(hash, &s, errtext))) {
+		StringHash::size_type i;
+		if(unlikely(!read_num(&i, errtext))) {
 			return false;
 		}
-		iuse->insert_fast(s);
+		iuse_std.EMPLACE_BACK(IUse, (hash[i]));
 	}
+	iuse->assign(&iuse_std);
 	return true;
 }
 
@@ -245,32 +248,63 @@ bool Database::write_version(const Version *v, const DBHeader& hdr, string *errt
 	return true;
 }
 
+bool Database::read_depend_tokens(const DBHeader& hdr, Depend::Tokens *tokens, string *errtext) {
+	Depend::Tokens::size_type e;
+	if(unlikely(!read_num(&e, errtext))) {
+		return false;
+	}
+	tokens->resize(e);
+	for(Depend::Tokens::iterator it(tokens->begin()); likely(it != tokens->end()); ++it) {
+		StringHash::size_type i;
+		if(unlikely(!read_num(&i, errtext))) {
+			return false;
+		}
+		*it = hdr.depend_token(i);
+	}
+	return true;
+}
+
+bool Database::write_depend_tokens(const DBHeader& hdr, const Depend::Tokens& tokens, string *errtext) {
+	if(unlikely(!write_num(tokens.size(), errtext))) {
+		return false;
+	}
+	for(Depend::Tokens::const_iterator it(tokens.begin()); likely(it != tokens.end()); ++it) {
+		if(unlikely(!write_hash_string(hdr.depend_hash, Depend::word(*it), errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
 bool Database::read_depend(Depend *dep, const DBHeader& hdr, string *errtext) {
 	string::size_type len;
 	if(unlikely(!read_num(&len, errtext))) {
 		return false;
 	}
 	if(Depend::use_depend) {
-		if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_depend), errtext))) {
+		dep->m_joined.clear();
+		if(unlikely(!read_depend_tokens(hdr, &(dep->m_depend), errtext))) {
 			return false;
 		}
-		if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_rdepend), errtext))) {
+		if(unlikely(!read_depend_tokens(hdr, &(dep->m_rdepend), errtext))) {
 			return false;
 		}
-		if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_pdepend), errtext))) {
+		if(unlikely(!read_depend_tokens(hdr, &(dep->m_pdepend), errtext))) {
 			return false;
 		}
 		if(hdr.version <= 31) {
 			dep->m_bdepend.clear();
-		} else if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_bdepend), errtext))) {
+		} else if(unlikely(!read_depend_tokens(hdr, &(dep->m_bdepend), errtext))) {
 			return false;
 		}
 		if(hdr.version <= 38) {
 			dep->m_idepend.clear();
-		} else if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_idepend), errtext))) {
+		} else if(unlikely(!read_depend_tokens(hdr, &(dep->m_idepend), errtext))) {
 			return false;
 		}
-		dep->obsolete = (hdr.version <= 32);
+		if(unlikely(hdr.version <= 32)) {
+			dep->normalize_obsolete();
+		}
 	} else {
 		dep->clear();
 GCC_DIAG_OFF(sign-conversion)
@@ -283,11 +317,11 @@ GCC_DIAG_ON(sign-conversion)
 }
 
 bool Database::write_depend(const Depend& dep, const DBHeader& hdr, string *errtext) {
-	return (likely(write_hash_words(hdr.depend_hash, dep.m_depend, errtext)) &&
-		likely(write_hash_words(hdr.depend_hash, dep.m_rdepend, errtext)) &&
-		likely(write_hash_words(hdr.depend_hash, dep.m_pdepend, errtext)) &&
-		likely(write_hash_words(hdr.depend_hash, dep.m_bdepend, errtext)) &&
-		likely(write_hash_words(hdr.depend_hash, dep.m_idepend, errtext)));
+	return (likely(write_depend_tokens(hdr, dep.m_depend, errtext)) &&
+		likely(write_depend_tokens(hdr, dep.m_rdepend, errtext)) &&
+		likely(write_depend_tokens(hdr, dep.m_pdepend, errtext)) &&
+		likely(write_depend_tokens(hdr, dep.m_bdepend, errtext)) &&
+		likely(write_depend_tokens(hdr, dep.m_idepend, errtext)));
 }
 
 bool Database::read_category_header(string *name, eix::Treesize *h, string *errtext) {
@@ -327,6 +361,37 @@ bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, strin
 	return true;
 }
 
+bool Database::read_package_pure(Package *pkg, const DBHeader& hdr, string *errtext) {
+	if(unlikely(!read_string(&(pkg->name), errtext))) {
+		return false;
+	}
+	if(unlikely(!read_string(&(pkg->desc), errtext))) {
+		return false;
+	}
+	if(unlikely(!read_string(&(pkg->homepage), errtext))) {
+		return false;
+	}
+	if(unlikely(!read_hash_string(hdr.license_hash, &(pkg->licenses), errtext))) {
+		return false;
+	}
+
+	// read all version entries
+	eix::Versize i;
+	if(unlikely(!read_num(&i, errtext))) {
+		return false;
+	}
+	pkg->reserve(i);
+	for(; likely(i != 0); --i) {
+		Version *v(new Version());
+		if(unlikely(!read_version(v, hdr, errtext))) {
+			delete v;
+			return false;
+		}
+		pkg->addVersion(v);
+	}
+	return true;
+}
+
 bool Database::write_package(const Package& pkg, const DBHeader& hdr, string *errtext) {
 	WRITE_COUNTER(write_package_pure(pkg, hdr, NULLPTR));
 	return write_package_pure(pkg, hdr, errtext);
@@ -345,6 +410,12 @@ bool Database::write_hash(const StringHash& hash, string *errtext) {
 	return true;
 }
 
+void Database::hash_depend_tokens(StringHash *hash, const Depend::Tokens& tokens) {
+	for(Depend::Tokens::const_iterator it(tokens.begin()); likely(it != tokens.end()); ++it) {
+		hash->hash_string(Depend::word(*it));
+	}
+}
+
 void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 	hdr->eapi_hash.init(true);
 	hdr->license_hash.init(true);
@@ -373,11 +444,11 @@ void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 				hdr->slot_hash.hash_string(v->get_shortfullslot());
 				if(use_dep) {
 					const Depend& dep(v->depend);
-					hdr->depend_hash.hash_words(dep.m_depend);
-					hdr->depend_hash.hash_words(dep.m_rdepend);
-					hdr->depend_hash.hash_words(dep.m_pdepend);
-					hdr->depend_hash.hash_words(dep.m_bdepend);
-					hdr->depend_hash.hash_words(dep.m_idepend);
+					hash_depend_tokens(&(hdr->depend_hash), dep.m_depend);
+					hash_depend_tokens(&(hdr->depend_hash), dep.m_rdepend);
+					hash_depend_tokens(&(hdr->depend_hash), dep.m_pdepend);
+					hash_depend_tokens(&(hdr->depend_hash), dep.m_bdepend);
+					hash_depend_tokens(&(hdr->depend_hash), dep.m_idepend);
 				}
 			}
 		}
@@ -402,6 +473,9 @@ bool Database::write_header(const DBHeader& hdr, string *errtext) {
 	if(unlikely(!write_num(hdr.size, errtext))) {
 		return false;
 	}
+	if(unlikely(!write_num(hdr.generation, errtext))) {
+		return false;
+	}
 
 	if(unlikely(!write_num(hdr.countOverlays(), errtext))) {
 		return false;
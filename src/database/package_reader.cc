@@ -11,6 +11,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include "database/io.h"
+#include "database/stability.h"
 #include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
@@ -71,6 +72,7 @@ bool PackageReader::read(Attributes need) {
 					m_error = true;
 					return false;
 				}
+				m_pkg->reserve(i);
 				for(; likely(i != 0); --i) {
 					Version *v(new Version());
 					if(unlikely(!m_db->read_version(v, *header, &m_errtext))) {
@@ -80,15 +82,30 @@ bool PackageReader::read(Attributes need) {
 					m_pkg->addVersion(v);
 				}
 			}
+			if(unlikely(need == VERSIONS_RAW)) {
+				break;
+			}
+			ATTRIBUTE_FALLTHROUGH
+		case VERSIONS_RAW:
 			if(likely(m_portagesettings != NULLPTR)) {
 				m_portagesettings->calc_local_sets(m_pkg);
+			}
+			if(unlikely(need == SETS)) {
+				break;
+			}
+			ATTRIBUTE_FALLTHROUGH
+		case SETS:
+			if(likely(m_portagesettings != NULLPTR)) {
 				m_portagesettings->finalize(m_pkg);
 			} else {
 				m_pkg->finalize_masks();
 			}
 			m_pkg->save_maskflags(Version::SAVEMASK_FILE);
+			if(m_stability != NULLPTR) {
+				m_stability->apply(m_pkg, m_count - 1);
+			}
 		default:
-		// case ALL:
+		// case VERSIONS:
 			break;
 	}
 	m_have = need;
@@ -96,8 +113,8 @@ bool PackageReader::read(Attributes need) {
 }
 
 bool PackageReader::skip() {
-	// only seek if needed
-	if(m_have != ALL) {
+	// only seek if needed: After the versions, we are at the next package
+	if(m_have < VERSIONS_RAW) {
 		if(unlikely(!m_db->seekabs(m_next, &m_errtext))) {
 			m_error = true;
 			return false;
@@ -128,6 +145,7 @@ bool PackageReader::next() {
 			m_error = true;
 			return false;
 		}
+		m_category = m_cat_name;
 		return next();
 	}
 
@@ -140,8 +158,8 @@ bool PackageReader::next() {
 	m_have = NONE;
 	delete m_pkg;
 	m_pkg = new Package;
-	m_pkg->category = m_cat_name;
-
+	m_pkg->category = m_category;
+	++m_count;
 	return true;
 }
 
@@ -152,6 +170,7 @@ bool PackageReader::nextCategory() {
 	}
 
 	if(likely(m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
+		m_category = m_cat_name;
 		return true;
 	}
 	m_error = true;
@@ -174,7 +193,7 @@ bool PackageReader::nextPackage() {
 	m_have = NONE;
 	delete m_pkg;
 	m_pkg = new Package;
-	m_pkg->category = m_cat_name;
+	m_pkg->category = m_category;
 	return read(ALL);
 }
 #endif
@@ -20,21 +20,30 @@
 #include "database/header.h"
 #include "eixTk/eixint.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
 
 class Database;
 class DBHeader;
 class Package;
 class PortageSettings;
+class StabilityIndex;
 
 /**
 Forward-iterate for packages stored in the cachefile
 **/
 class PackageReader {
 	public:
+		/**
+		The versions are decoded in three steps:
+		VERSIONS_RAW: only the data stored in the database
+		SETS: additionally the local package sets
+		VERSIONS: additionally the world sets and finalized masks
+		**/
 		enum Attributes {
 			NONE = 0,
-			NAME, DESCRIPTION, HOMEPAGE, LICENSE, VERSIONS,
-			ALL = 7
+			NAME, DESCRIPTION, HOMEPAGE, LICENSE,
+			VERSIONS_RAW, SETS, VERSIONS,
+			ALL = VERSIONS
 		};
 
 		/**
@@ -42,15 +51,23 @@ class PackageReader {
 		@arg ps is used to define the local package sets while version reading
 		**/
 		PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_count(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_stability(NULLPTR), m_error(false) {
 		}
 
 		PackageReader(Database *db, const DBHeader& hdr)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_count(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_stability(NULLPTR), m_error(false) {
 		}
 
 		~PackageReader();
 
+		/**
+		Use the local flags of index (if available) when the versions
+		are read completely
+		**/
+		void set_stability_index(const StabilityIndex *index) {
+			m_stability = index;
+		}
+
 		/**
 		Read attributes from the database into the current package
 		**/
@@ -118,12 +135,23 @@ class PackageReader {
 		eix::Treesize     m_cat_size;
 		std::string       m_cat_name;
 
+		/**
+		m_cat_name in the pool, so that packages need not copy it
+		**/
+		SharedString      m_category;
+
+		/**
+		Number of packages including the current one
+		**/
+		eix::Treesize     m_count;
+
 		off_t             m_next;
 		Attributes        m_have;
 		Package          *m_pkg;
 
 		const DBHeader   *header;
 		PortageSettings  *m_portagesettings;
+		const StabilityIndex *m_stability;
 
 		std::string m_errtext;
 		bool m_error;
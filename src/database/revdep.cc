@@ -0,0 +1,212 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/revdep.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "database/io.h"
+#include "database/trigram.h"
+#include "eixTk/auto_array.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "portage/depend.h"
+#include "portage/package.h"
+#include "portage/packagetree.h"
+#include "portage/version.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+const char ReverseDependIndex::magic[] = "eix-revdep\n";
+const char ReverseDependIndex::suffix[] = ".revdep";
+
+/**
+A dependency of a version on some atom
+**/
+class RevdepEntry {
+	public:
+		eix::Treesize package;
+		eix::Versize version;
+		Depend::Classes classes;
+
+		RevdepEntry(eix::Treesize p, eix::Versize v, Depend::Classes c)
+			: package(p), version(v), classes(c) {
+		}
+};
+
+typedef map<string, vector<RevdepEntry> > RevdepMap;
+
+bool ReverseDependIndex::write_index(const char *indexfile, const char *dbfile, const PackageTree& tree, string *errtext) {
+	eix::OffsetType dbsize;
+	eix::UNumber dbmtime, dbgeneration;
+	if(unlikely(!TrigramIndex::dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration))) {
+		*errtext = eix::format(_("cannot stat database file %s")) % dbfile;
+		return false;
+	}
+	RevdepMap revdeps;
+	eix::Treesize n(0);
+	Depend::Atoms atoms;
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		Category *ci(c->second);
+		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p, ++n) {
+			eix::Versize v(0);
+			for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it, ++v) {
+				atoms.clear();
+				it->depend.get_atoms(&atoms);
+				for(Depend::Atoms::const_iterator a(atoms.begin()); likely(a != atoms.end()); ++a) {
+					revdeps[a->first].PUSH_BACK(RevdepEntry(n, v, a->second));
+				}
+			}
+		}
+	}
+
+	// The entries are collected first, since the directory at the beginning
+	// contains their lengths. The package numbers are delta encoded.
+	Database out;
+	string directory, data;
+	for(RevdepMap::const_iterator it(revdeps.begin()); likely(it != revdeps.end()); ++it) {
+		string::size_type begin(data.size());
+		out.write_to_string(&data);
+		out.write_num(it->second.size(), NULLPTR);
+		eix::Treesize prev(0);
+		for(vector<RevdepEntry>::const_iterator e(it->second.begin());
+			likely(e != it->second.end()); ++e) {
+			out.write_num(e->package - prev, NULLPTR);
+			out.write_num(e->version, NULLPTR);
+			out.write_num(e->classes, NULLPTR);
+			prev = e->package;
+		}
+		out.write_to_string(&directory);
+		out.write_string(it->first, NULLPTR);
+		out.write_num(data.size() - begin, NULLPTR);
+	}
+	out.write_to_string(NULLPTR);
+
+	if(unlikely(!out.openwrite(indexfile))) {
+		*errtext = eix::format(_("cannot open reverse dependency index %s for writing (mode = 'wb')")) % indexfile;
+		return false;
+	}
+	if(likely(out.write_string_plain(magic, errtext) &&
+		out.write_num(current, errtext) &&
+		out.write_num(dbsize, errtext) &&
+		out.write_num(dbmtime, errtext) &&
+		out.write_num(dbgeneration, errtext) &&
+		out.write_num(n, errtext) &&
+		out.write_num(revdeps.size(), errtext) &&
+		out.write_string_plain(directory, errtext) &&
+		out.write_string_plain(data, errtext))) {
+		return true;
+	}
+	out.destroy();
+	std::remove(indexfile);
+	return false;
+}
+
+bool ReverseDependIndex::open(const char *indexfile, const char *dbfile) {
+	eix::OffsetType dbsize, size;
+	eix::UNumber dbmtime, mtime, dbgeneration, generation;
+	if(!TrigramIndex::dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration) || !db.openread(indexfile)) {
+		return false;
+	}
+	size_t magic_len(std::strlen(magic));
+	eix::auto_array<char> buf(new char[magic_len + 1]);
+	buf.get()[magic_len] = 0;
+	IndexVersion version;
+	if(unlikely(!db.read_string_plain(buf.get(), magic_len, NULLPTR) ||
+		(std::strcmp(magic, buf.get()) != 0) ||
+		!db.read_num(&version, NULLPTR) || (version != current) ||
+		!db.read_num(&size, NULLPTR) || (size != dbsize) ||
+		!db.read_num(&mtime, NULLPTR) || (mtime != dbmtime) ||
+		!db.read_num(&generation, NULLPTR) || (generation != dbgeneration) ||
+		!db.read_num(&packages, NULLPTR) ||
+		!db.read_num(&atoms, NULLPTR))) {
+		db.destroy();
+		return false;
+	}
+	start = db.tell();
+	directory_read = false;
+	names.clear();
+	offsets.clear();
+	return true;
+}
+
+/**
+The directory is only needed for --required-by,
+so it is not read before the first lookup
+**/
+bool ReverseDependIndex::read_directory() {
+	if(directory_read) {
+		return directory_ok;
+	}
+	directory_read = true;
+	directory_ok = false;
+	if(unlikely(!db.seekabs(start, NULLPTR))) {
+		return false;
+	}
+	names.resize(atoms);
+	offsets.resize(atoms);
+	vector<eix::OffsetType> lengths(atoms);
+	for(eix::Treesize i(0); likely(i != atoms); ++i) {
+		if(unlikely(!db.read_string(&(names[i]), NULLPTR) ||
+			!db.read_num(&(lengths[i]), NULLPTR))) {
+			names.clear();
+			offsets.clear();
+			return false;
+		}
+	}
+	eix::OffsetType offset(db.tell());
+	for(eix::Treesize i(0); likely(i != atoms); ++i) {
+		offsets[i] = offset;
+		offset += lengths[i];
+	}
+	directory_ok = true;
+	return true;
+}
+
+bool ReverseDependIndex::lookup(PackageSet *set, const string& atom, Depend::Classes classes) {
+	if(unlikely(!read_directory())) {
+		return false;
+	}
+	set->assign(packages, false);
+	vector<string>::const_iterator it(std::lower_bound(names.begin(), names.end(), atom));
+	if((it == names.end()) || (*it != atom)) {
+		return true;
+	}
+	eix::Treesize count;
+	if(unlikely(!db.seekabs(offsets[it - names.begin()], NULLPTR) ||
+		!db.read_num(&count, NULLPTR))) {
+		return false;
+	}
+	eix::Treesize n(0);
+	for(; likely(count != 0); --count) {
+		eix::Treesize diff;
+		eix::Versize version;
+		Depend::Classes c;
+		if(unlikely(!db.read_num(&diff, NULLPTR) ||
+			!db.read_num(&version, NULLPTR) ||
+			!db.read_num(&c, NULLPTR))) {
+			return false;
+		}
+		n += diff;
+		if(((c & classes) != Depend::CLASS_NONE) && likely(n < packages)) {
+			(*set)[n] = true;
+		}
+	}
+	return true;
+}
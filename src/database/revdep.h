@@ -0,0 +1,90 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_REVDEP_H_
+#define SRC_DATABASE_REVDEP_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include "database/io.h"
+#include "database/trigram.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "portage/depend.h"
+
+class PackageTree;
+
+/**
+An index of the reverse dependencies of a database:
+For each category/name occurring in some dependency string it contains
+the list of (package, version, classes of dependencies) which refer to it.
+Packages are identified by their position in the database,
+versions by their position in the package.
+A sorted directory of the names is read at the first lookup.
+**/
+class ReverseDependIndex {
+	public:
+		typedef eix::UNumber IndexVersion;
+		typedef TrigramIndex::PackageSet PackageSet;
+
+		static const char magic[];
+		static const char suffix[];
+
+		/**
+		Current version of the index format
+		**/
+		static CONSTEXPR const IndexVersion current = 4;
+
+		ReverseDependIndex() : packages(0), atoms(0), start(0), directory_read(false), directory_ok(false) {
+		}
+
+		/**
+		Write the index for tree to indexfile.
+		The database dbfile must already have been written completely.
+		**/
+		ATTRIBUTE_NONNULL_ static bool write_index(const char *indexfile, const char *dbfile, const PackageTree& tree, std::string *errtext);
+
+		/**
+		Open indexfile and read its header.
+		@return false if the index is missing or does not belong to dbfile
+		**/
+		ATTRIBUTE_NONNULL_ bool open(const char *indexfile, const char *dbfile);
+
+		/**
+		Set *set to the packages with a version having a dependency of
+		some of the classes on atom (category/name).
+		@return false if the index cannot restrict the packages
+		**/
+		ATTRIBUTE_NONNULL_ bool lookup(PackageSet *set, const std::string& atom, Depend::Classes classes);
+
+		/**
+		@return number of packages in the indexed database
+		**/
+		eix::Treesize size() const {
+			return packages;
+		}
+
+	private:
+		Database db;
+		eix::Treesize packages, atoms;
+		eix::OffsetType start;
+		bool directory_read, directory_ok;
+		std::vector<std::string> names;
+		std::vector<eix::OffsetType> offsets;
+
+		/**
+		Read the directory of the atoms if this was not done yet
+		@return false if the index cannot be used
+		**/
+		bool read_directory();
+};
+
+#endif  // SRC_DATABASE_REVDEP_H_
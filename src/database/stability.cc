@@ -0,0 +1,212 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/stability.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <string>
+
+#include "database/header.h"
+#include "database/io.h"
+#include "database/package_reader.h"
+#include "database/trigram.h"
+#include "eixTk/auto_array.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/utils.h"
+#include "portage/conf/portagesettings.h"
+#include "portage/keywords.h"
+#include "portage/package.h"
+#include "portage/set_stability.h"
+#include "portage/version.h"
+
+using std::string;
+
+const char StabilityIndex::magic[] = "eix-stability\n";
+const char StabilityIndex::suffix[] = ".stability";
+
+bool StabilityIndex::write_index(const char *indexfile, const char *dbfile, PortageSettings *settings, const WordSet& files, std::time_t start, string *errtext) {
+	eix::OffsetType dbsize;
+	eix::UNumber dbmtime, dbgeneration;
+	if(unlikely(!TrigramIndex::dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration))) {
+		*errtext = eix::format(_("cannot stat database file %s")) % dbfile;
+		return false;
+	}
+	Database out;
+	string data;
+	out.write_to_string(&data);
+	string fingerprint;
+	settings->append_stability_settings(&fingerprint);
+	out.write_string(fingerprint, NULLPTR);
+	out.write_num(files.size(), NULLPTR);
+	string sig;
+	for(WordSet::const_iterator it(files.begin()); likely(it != files.end()); ++it) {
+		if(unlikely(file_signature(&sig, *it) >= start)) {
+			*errtext = eix::format(_("%s was modified while writing the stability index")) % (*it);
+			return false;
+		}
+		out.write_string(*it, NULLPTR);
+		out.write_string(sig, NULLPTR);
+	}
+
+	// Calculate the flags exactly as eix would do after reading the database
+	Database db;
+	DBHeader header;
+	if(unlikely(!db.openread(dbfile))) {
+		*errtext = eix::format(_("cannot open database file %s for reading (mode = 'rb')")) % dbfile;
+		return false;
+	}
+	if(unlikely(!db.read_header(&header, errtext, DBHeader::current))) {
+		return false;
+	}
+	SetStability stability(settings, true, false, false);
+	PackageReader reader(&db, header, settings);
+	eix::Treesize n(0);
+	for(; likely(reader.next()); ++n) {
+		Package *p(reader.release());
+		if(unlikely(p == NULLPTR)) {
+			break;
+		}
+		stability.set_stability(p);
+		bool have_reasons(false);
+		for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it) {
+			if(unlikely(it->have_reasons())) {
+				have_reasons = true;
+				break;
+			}
+		}
+		if(unlikely(have_reasons)) {
+			out.write_num(0, NULLPTR);
+		} else {
+			out.write_num(p->size(), NULLPTR);
+			for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it) {
+				out.write_num(it->maskflags.get(), NULLPTR);
+				out.write_num(it->keyflags.get(), NULLPTR);
+			}
+		}
+		delete p;
+	}
+	const char *err_cstr(reader.get_errtext());
+	if(unlikely(err_cstr != NULLPTR)) {
+		*errtext = err_cstr;
+		return false;
+	}
+	out.write_to_string(NULLPTR);
+
+	if(unlikely(!out.openwrite(indexfile))) {
+		*errtext = eix::format(_("cannot open stability index %s for writing (mode = 'wb')")) % indexfile;
+		return false;
+	}
+	if(likely(out.write_string_plain(magic, errtext) &&
+		out.write_num(current, errtext) &&
+		out.write_num(dbsize, errtext) &&
+		out.write_num(dbmtime, errtext) &&
+		out.write_num(dbgeneration, errtext) &&
+		out.write_num(n, errtext) &&
+		out.write_string_plain(data, errtext))) {
+		return true;
+	}
+	out.destroy();
+	std::remove(indexfile);
+	return false;
+}
+
+bool StabilityIndex::open(const char *indexfile, const char *dbfile, const PortageSettings& settings) {
+	eix::OffsetType dbsize, size;
+	eix::UNumber dbmtime, mtime, dbgeneration, generation;
+	Database db;
+	if(!TrigramIndex::dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration) || !db.openread(indexfile)) {
+		return false;
+	}
+	size_t magic_len(std::strlen(magic));
+	eix::auto_array<char> buf(new char[magic_len + 1]);
+	buf.get()[magic_len] = 0;
+	IndexVersion version;
+	string fingerprint;
+	eix::Treesize files;
+	if(unlikely(!db.read_string_plain(buf.get(), magic_len, NULLPTR) ||
+		(std::strcmp(magic, buf.get()) != 0) ||
+		!db.read_num(&version, NULLPTR) || (version != current) ||
+		!db.read_num(&size, NULLPTR) || (size != dbsize) ||
+		!db.read_num(&mtime, NULLPTR) || (mtime != dbmtime) ||
+		!db.read_num(&generation, NULLPTR) || (generation != dbgeneration) ||
+		!db.read_num(&m_packages, NULLPTR) ||
+		!db.read_string(&fingerprint, NULLPTR) ||
+		!db.read_num(&files, NULLPTR))) {
+		return false;
+	}
+	string current_fingerprint;
+	settings.append_stability_settings(&current_fingerprint);
+	if(fingerprint != current_fingerprint) {
+		return false;
+	}
+	string file, sig, current_sig;
+	for(; likely(files != 0); --files) {
+		if(unlikely(!db.read_string(&file, NULLPTR) ||
+			!db.read_string(&sig, NULLPTR))) {
+			return false;
+		}
+		file_signature(&current_sig, file);
+		if(sig != current_sig) {
+			return false;
+		}
+	}
+	m_flags.clear();
+	m_starts.clear();
+	m_starts.reserve(m_packages + 1);
+	for(eix::Treesize i(0); likely(i != m_packages); ++i) {
+		m_starts.PUSH_BACK(m_flags.size());
+		eix::Versize count;
+		if(unlikely(!db.read_num(&count, NULLPTR))) {
+			m_starts.clear();
+			return false;
+		}
+		for(count *= 2; likely(count != 0); --count) {
+			eix::UChar c;
+			if(unlikely(!db.read_num(&c, NULLPTR))) {
+				m_starts.clear();
+				return false;
+			}
+			m_flags.PUSH_BACK(c);
+		}
+	}
+	m_starts.PUSH_BACK(m_flags.size());
+	return true;
+}
+
+bool StabilityIndex::apply(Package *p, eix::Treesize pkgnum) const {
+	if(unlikely(pkgnum >= m_packages)) {
+		return false;
+	}
+	Flags::size_type i(m_starts[pkgnum]);
+	if((m_starts[pkgnum + 1] - i) != 2 * p->size()) {
+		return false;
+	}
+	MaskFlags collects(MaskFlags::MASK_NONE);
+	for(Package::iterator it(p->begin()); likely(it != p->end()); ++it) {
+		MaskFlags maskflags(it->maskflags);
+		KeywordsFlags keyflags(it->keyflags);
+		it->maskflags.set(m_flags[i++]);
+		it->keyflags.set_keyflags(m_flags[i++]);
+		collects.setbits(it->maskflags.get());
+		it->save_maskflags(Version::SAVEMASK_USER);
+		it->save_keyflags(Version::SAVEKEY_USER);
+		it->maskflags = maskflags;
+		it->keyflags = keyflags;
+	}
+	p->saved_collects[Version::SAVEMASK_USER] = collects;
+	return true;
+}
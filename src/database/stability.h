@@ -0,0 +1,89 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_STABILITY_H_
+#define SRC_DATABASE_STABILITY_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <ctime>
+
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/stringtypes.h"
+
+class Package;
+class PortageSettings;
+
+/**
+An index of the local stability of a database: For each package it
+contains the mask and keyword flags of its versions resulting from
+/etc/portage, together with a fingerprint of all files and settings
+which were consulted for them.
+Packages whose versions have mask reasons are omitted, since the reasons
+are not stored.
+**/
+class StabilityIndex {
+	public:
+		typedef eix::UNumber IndexVersion;
+
+		static const char magic[];
+		static const char suffix[];
+
+		/**
+		Current version of the index format
+		**/
+		static CONSTEXPR const IndexVersion current = 2;
+
+		StabilityIndex() : m_packages(0) {
+		}
+
+		/**
+		Write the index for the database dbfile which must already have
+		been written completely.
+		@param settings the settings with local configuration
+		@param files the files and directories read for settings
+		@param start the time before settings were initialized
+		**/
+		ATTRIBUTE_NONNULL_ static bool write_index(const char *indexfile, const char *dbfile, PortageSettings *settings, const WordSet& files, std::time_t start, std::string *errtext);
+
+		/**
+		Read indexfile into memory.
+		@return false if the index is missing, does not belong to dbfile,
+		or if some of the files or settings have changed
+		**/
+		ATTRIBUTE_NONNULL_ bool open(const char *indexfile, const char *dbfile, const PortageSettings& settings);
+
+		/**
+		Save the local flags of package number pkgnum for p as if they
+		had been calculated.
+		@return false if the index has no flags for the package
+		**/
+		ATTRIBUTE_NONNULL_ bool apply(Package *p, eix::Treesize pkgnum) const;
+
+	private:
+		typedef std::vector<eix::UChar> Flags;
+		typedef std::vector<Flags::size_type> Starts;
+
+		eix::Treesize m_packages;
+
+		/**
+		Mask and keyword flags of the versions of all packages
+		**/
+		Flags m_flags;
+
+		/**
+		Start of the flags of each package in m_flags
+		**/
+		Starts m_starts;
+};
+
+#endif  // SRC_DATABASE_STABILITY_H_
@@ -0,0 +1,258 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/trigram.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "database/io.h"
+#include "eixTk/auto_array.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "portage/depend.h"
+#include "portage/extendedversion.h"
+#include "portage/package.h"
+#include "portage/packagetree.h"
+#include "portage/version.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+const char TrigramIndex::magic[] = "eix-trigram\n";
+const char TrigramIndex::suffix[] = ".trigram";
+
+/**
+Pseudo trigram whose postings are the packages with non-ASCII characters
+**/
+static CONSTEXPR const TrigramIndex::Trigram non_ascii = 0xFFFFFFFFU;
+
+typedef map<TrigramIndex::Trigram, vector<eix::Treesize> > Postings;
+
+ATTRIBUTE_NONNULL_ static void add_trigrams(vector<TrigramIndex::Trigram> *v, bool *nonascii, const string& s);
+
+bool TrigramIndex::dbstamp(const char *dbfile, eix::OffsetType *size, eix::UNumber *mtime, eix::UNumber *generation) {
+	struct stat st;
+	if(unlikely(stat(dbfile, &st) != 0)) {
+		return false;
+	}
+	*size = st.st_size;
+	*mtime = static_cast<eix::UNumber>(st.st_mtime);
+	return Database::read_generation(dbfile, generation);
+}
+
+static void add_trigrams(vector<TrigramIndex::Trigram> *v, bool *nonascii, const string& s) {
+	TrigramIndex::Trigram t(0);
+	string::size_type len(0);
+	for(string::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
+		unsigned char c(static_cast<unsigned char>(*it));
+		if(unlikely(c >= 0x80)) {
+			*nonascii = true;
+		} else if((c >= 'A') && (c <= 'Z')) {
+			c = static_cast<unsigned char>(c - 'A' + 'a');
+		}
+		t = ((t << 8) | c) & 0xFFFFFFU;
+		if(++len >= 3) {
+			v->push_back(t);
+		}
+	}
+}
+
+bool TrigramIndex::write_index(const char *indexfile, const char *dbfile, const PackageTree& tree, string *errtext) {
+	eix::OffsetType dbsize;
+	eix::UNumber dbmtime, dbgeneration;
+	if(unlikely(!dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration))) {
+		*errtext = eix::format(_("cannot stat database file %s")) % dbfile;
+		return false;
+	}
+	Postings postings;
+	eix::Treesize n(0);
+	vector<Trigram> v;
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		Category *ci(c->second);
+		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p, ++n) {
+			bool nonascii(false);
+			v.clear();
+			add_trigrams(&v, &nonascii, c->first + "/" + p->name);
+			add_trigrams(&v, &nonascii, p->desc);
+			add_trigrams(&v, &nonascii, p->homepage);
+			add_trigrams(&v, &nonascii, p->licenses);
+			for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it) {
+				add_trigrams(&v, &nonascii, it->src_uri);
+				if(Depend::use_depend) {
+					const Depend& dep(it->depend);
+					add_trigrams(&v, &nonascii, dep.get_depend());
+					add_trigrams(&v, &nonascii, dep.get_rdepend());
+					add_trigrams(&v, &nonascii, dep.get_pdepend());
+					add_trigrams(&v, &nonascii, dep.get_bdepend());
+					add_trigrams(&v, &nonascii, dep.get_idepend());
+				}
+			}
+			std::sort(v.begin(), v.end());
+			v.erase(std::unique(v.begin(), v.end()), v.end());
+			for(vector<Trigram>::const_iterator it(v.begin()); likely(it != v.end()); ++it) {
+				postings[*it].push_back(n);
+			}
+			if(unlikely(nonascii)) {
+				postings[non_ascii].push_back(n);
+			}
+		}
+	}
+
+	// The posting lists are delta encoded and collected first,
+	// since the directory at the beginning contains their lengths
+	Database out;
+	string directory, data;
+	for(Postings::const_iterator it(postings.begin()); likely(it != postings.end()); ++it) {
+		string::size_type start(data.size());
+		out.write_to_string(&data);
+		out.write_num(it->second.size(), NULLPTR);
+		eix::Treesize prev(0);
+		for(vector<eix::Treesize>::const_iterator p(it->second.begin());
+			likely(p != it->second.end()); ++p) {
+			out.write_num(*p - prev, NULLPTR);
+			prev = *p;
+		}
+		out.write_to_string(&directory);
+		out.write_num(it->first, NULLPTR);
+		out.write_num(data.size() - start, NULLPTR);
+	}
+	out.write_to_string(NULLPTR);
+
+	if(unlikely(!out.openwrite(indexfile))) {
+		*errtext = eix::format(_("cannot open trigram index %s for writing (mode = 'wb')")) % indexfile;
+		return false;
+	}
+	if(likely(out.write_string_plain(magic, errtext) &&
+		out.write_num(current, errtext) &&
+		out.write_num(dbsize, errtext) &&
+		out.write_num(dbmtime, errtext) &&
+		out.write_num(dbgeneration, errtext) &&
+		out.write_num(n, errtext) &&
+		out.write_num(postings.size(), errtext) &&
+		out.write_string_plain(directory, errtext) &&
+		out.write_string_plain(data, errtext))) {
+		return true;
+	}
+	out.destroy();
+	std::remove(indexfile);
+	return false;
+}
+
+bool TrigramIndex::open(const char *indexfile, const char *dbfile) {
+	eix::OffsetType dbsize, size;
+	eix::UNumber dbmtime, mtime, dbgeneration, generation;
+	if(!dbstamp(dbfile, &dbsize, &dbmtime, &dbgeneration) || !db.openread(indexfile)) {
+		return false;
+	}
+	size_t magic_len(std::strlen(magic));
+	eix::auto_array<char> buf(new char[magic_len + 1]);
+	buf.get()[magic_len] = 0;
+	IndexVersion version;
+	vector<Trigram>::size_type count;
+	if(unlikely(!db.read_string_plain(buf.get(), magic_len, NULLPTR) ||
+		(std::strcmp(magic, buf.get()) != 0) ||
+		!db.read_num(&version, NULLPTR) || (version != current) ||
+		!db.read_num(&size, NULLPTR) || (size != dbsize) ||
+		!db.read_num(&mtime, NULLPTR) || (mtime != dbmtime) ||
+		!db.read_num(&generation, NULLPTR) || (generation != dbgeneration) ||
+		!db.read_num(&packages, NULLPTR) ||
+		!db.read_num(&count, NULLPTR))) {
+		db.destroy();
+		return false;
+	}
+	trigrams.resize(count);
+	offsets.resize(count);
+	vector<eix::OffsetType> lengths(count);
+	for(vector<Trigram>::size_type i(0); likely(i != count); ++i) {
+		if(unlikely(!db.read_num(&(trigrams[i]), NULLPTR) ||
+			!db.read_num(&(lengths[i]), NULLPTR))) {
+			trigrams.clear();
+			db.destroy();
+			return false;
+		}
+	}
+	eix::OffsetType offset(db.tell());
+	for(vector<Trigram>::size_type i(0); likely(i != count); ++i) {
+		offsets[i] = offset;
+		offset += lengths[i];
+	}
+	return true;
+}
+
+bool TrigramIndex::read_postings(PackageSet *set, vector<Trigram>::size_type i) {
+	eix::Treesize count;
+	if(unlikely(!db.seekabs(offsets[i], NULLPTR) ||
+		!db.read_num(&count, NULLPTR))) {
+		return false;
+	}
+	eix::Treesize n(0);
+	for(; likely(count != 0); --count) {
+		eix::Treesize diff;
+		if(unlikely(!db.read_num(&diff, NULLPTR))) {
+			return false;
+		}
+		n += diff;
+		if(likely(n < packages)) {
+			(*set)[n] = true;
+		}
+	}
+	return true;
+}
+
+bool TrigramIndex::lookup(PackageSet *set, const string& literal) {
+	vector<Trigram> v;
+	bool nonascii(false);
+	add_trigrams(&v, &nonascii, literal);
+	if(v.empty() || trigrams.empty()) {
+		return false;
+	}
+	std::sort(v.begin(), v.end());
+	v.erase(std::unique(v.begin(), v.end()), v.end());
+	set->assign(packages, false);
+	PackageSet found;
+	bool first(true);
+	for(vector<Trigram>::const_iterator it(v.begin()); likely(it != v.end()); ++it) {
+		vector<Trigram>::const_iterator t(std::lower_bound(trigrams.begin(), trigrams.end(), *it));
+		if((t == trigrams.end()) || (*t != *it)) {
+			set->assign(packages, false);
+			break;
+		}
+		if(first) {
+			first = false;
+			if(unlikely(!read_postings(set, static_cast<vector<Trigram>::size_type>(t - trigrams.begin())))) {
+				return false;
+			}
+			continue;
+		}
+		found.assign(packages, false);
+		if(unlikely(!read_postings(&found, static_cast<vector<Trigram>::size_type>(t - trigrams.begin())))) {
+			return false;
+		}
+		for(eix::Treesize n(0); likely(n != packages); ++n) {
+			if(!found[n]) {
+				(*set)[n] = false;
+			}
+		}
+	}
+	vector<Trigram>::const_iterator t(std::lower_bound(trigrams.begin(), trigrams.end(), non_ascii));
+	if((t != trigrams.end()) && (*t == non_ascii)) {
+		return read_postings(set, static_cast<vector<Trigram>::size_type>(t - trigrams.begin()));
+	}
+	return true;
+}
@@ -0,0 +1,95 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_TRIGRAM_H_
+#define SRC_DATABASE_TRIGRAM_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include "database/io.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/inttypes.h"
+
+class PackageTree;
+
+/**
+An index of the trigrams occurring in the full text fields of the packages
+(category/name, description, homepage, licenses, SRC_URI, and the available
+dependencies) of a database.
+Packages are identified by their position in the database.
+The trigrams are formed with ASCII case folding; packages containing
+non-ASCII characters are always considered as candidates.
+**/
+class TrigramIndex {
+	public:
+		typedef uint32_t Trigram;
+		typedef eix::UNumber IndexVersion;
+		typedef std::vector<bool> PackageSet;
+
+		static const char magic[];
+		static const char suffix[];
+
+		/**
+		Current version of the index format
+		**/
+		static CONSTEXPR const IndexVersion current = 2;
+
+		TrigramIndex() : packages(0) {
+		}
+
+		/**
+		Get size, mtime, and generation of dbfile which tie an index to the
+		database. The mtime has a resolution of seconds only, so without the
+		generation a database rewritten with the same size would not be
+		recognized.
+		**/
+		ATTRIBUTE_NONNULL_ static bool dbstamp(const char *dbfile, eix::OffsetType *size, eix::UNumber *mtime, eix::UNumber *generation);
+
+		/**
+		Write the index for tree to indexfile.
+		The database dbfile must already have been written completely.
+		**/
+		ATTRIBUTE_NONNULL_ static bool write_index(const char *indexfile, const char *dbfile, const PackageTree& tree, std::string *errtext);
+
+		/**
+		Open indexfile and read its directory.
+		@return false if the index is missing or does not belong to dbfile
+		**/
+		ATTRIBUTE_NONNULL_ bool open(const char *indexfile, const char *dbfile);
+
+		/**
+		Set *set to the packages which possibly contain literal
+		(with ASCII case folding).
+		@return false if the index cannot restrict the packages
+		**/
+		ATTRIBUTE_NONNULL_ bool lookup(PackageSet *set, const std::string& literal);
+
+		/**
+		@return number of packages in the indexed database
+		**/
+		eix::Treesize size() const {
+			return packages;
+		}
+
+	private:
+		Database db;
+		eix::Treesize packages;
+		std::vector<Trigram> trigrams;
+		std::vector<eix::OffsetType> offsets;
+
+		/**
+		Add the postings of the trigram with index i to set
+		**/
+		ATTRIBUTE_NONNULL_ bool read_postings(PackageSet *set, std::vector<Trigram>::size_type i);
+};
+
+#endif  // SRC_DATABASE_TRIGRAM_H_
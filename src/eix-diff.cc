@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 
+#include "database/delta.h"
 #include "database/header.h"
 #include "database/io.h"
 #include "database/package_reader.h"
@@ -51,7 +52,9 @@ using std::vector;
 
 static void print_help();
 ATTRIBUTE_NONNULL_ static void init_db(const char *file, Database *db, DBHeader *header, PackageReader **reader, PortageSettings *ps);
-ATTRIBUTE_NONNULL_ static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string& eprefix_virtual);
+ATTRIBUTE_NONNULL_ static void init_delta(const char *file, bool new_section, Database *db, DBHeader *header, PackageReader **reader, PortageSettings *ps);
+
+static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string& eprefix_virtual);
 ATTRIBUTE_NONNULL_ static void print_changed_package(Package *op, Package *np);
 ATTRIBUTE_NONNULL_ static void print_found_package(Package *p);
 ATTRIBUTE_NONNULL_ static void print_lost_package(Package *p);
@@ -67,6 +70,7 @@ static Node           *format_new, *format_delete, *format_changed;
 
 static void print_help() {
 	eix::say(_("Usage: %s [options] old-cache [new-cache]\n"
+"       %s [options] --delta delta-file\n"
 "\n"
 " -Q, --quick (toggle)    do (not) read unguessable slots of installed packages\n"
 "     --care              always read slots of installed packages\n"
@@ -79,12 +83,13 @@ static void print_help() {
 "     --dump-defaults     dump default values of variables\n"
 "     --print             print the expanded value of a variable\n"
 "     --known-vars        print all variable names known to --print\n"
+"     --delta FILE        read the changes from a delta file of eix-update\n"
 "\n"
 " -h, --help              show a short help screen\n"
 " -V, --version           show version-string\n"
 "\n"
 "This program is covered by the GNU General Public License. See COPYING for\n"
-"further information.")) % program_name;
+"further information.")) % program_name % program_name;
 }
 
 bool cli_show_help(false),
@@ -99,6 +104,7 @@ bool cli_show_help(false),
 	cli_quiet;
 
 const char *var_to_print(NULLPTR);
+const char *delta_file(NULLPTR);
 
 enum diff_options {
 	O_DUMP = 300,
@@ -108,7 +114,8 @@ enum diff_options {
 	O_CARE,
 	O_DEPS_INSTALLED,
 	O_ANSI,
-	O_FORCE_COLOR
+	O_FORCE_COLOR,
+	O_DELTA
 };
 
 
@@ -136,6 +143,7 @@ EixDiffOptionList::EixDiffOptionList() {
 	push_back(Option("deps_installed", O_DEPS_INSTALLED, Option::BOOLEAN_T, &cli_deps_installed));
 	push_back(Option("quiet",        'q',    Option::BOOLEAN,   &cli_quiet));
 	push_back(Option("ansi",         O_ANSI, Option::BOOLEAN_T, &cli_ansi));
+	push_back(Option("delta",        O_DELTA, Option::STRING,   &delta_file));
 }
 
 static void init_db(const char *file, Database *db, DBHeader *header, PackageReader **reader, PortageSettings *ps) {
@@ -154,6 +162,18 @@ static void init_db(const char *file, Database *db, DBHeader *header, PackageRea
 	std::exit(EXIT_FAILURE);
 }
 
+static void init_delta(const char *file, bool new_section, Database *db, DBHeader *header, PackageReader **reader, PortageSettings *ps) {
+	string errtext;
+	if(likely(DBDelta::open_section(db, header, file, new_section, &errtext))) {
+		*reader = new PackageReader(db, *header, ps);
+		header->set_priorities(ps);
+		ps->store_world_sets(&(header->world_sets));
+		return;
+	}
+	eix::say_error() % errtext;
+	std::exit(EXIT_FAILURE);
+}
+
 static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string& eprefix_virtual) {
 	if(header.countOverlays() == 0) {
 		return;
@@ -462,11 +482,16 @@ int run_eix_diff(int argc, char *argv[]) {
 
 	Database new_db;
 	new_header = new DBHeader;
-	init_db(new_file.c_str(), &new_db, new_header, &new_reader, portagesettings);
-
 	Database old_db;
 	old_header = new DBHeader;
-	init_db(old_file.c_str(), &old_db, old_header, &old_reader, portagesettings);
+	if(delta_file != NULLPTR) {
+		// Only changed packages are contained in the delta sections
+		init_delta(delta_file, true, &new_db, new_header, &new_reader, portagesettings);
+		init_delta(delta_file, false, &old_db, old_header, &old_reader, portagesettings);
+	} else {
+		init_db(new_file.c_str(), &new_db, new_header, &new_reader, portagesettings);
+		init_db(old_file.c_str(), &old_db, old_header, &old_reader, portagesettings);
+	}
 
 	format_for_new->set_overlay_translations(NULLPTR);
 
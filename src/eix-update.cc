@@ -13,17 +13,26 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "cache/cachetable.h"
+#include "database/delta.h"
+#include "database/fuzzy.h"
 #include "database/header.h"
 #include "database/io.h"
+#include "database/revdep.h"
+#include "database/stability.h"
+#include "database/trigram.h"
 #include "eixTk/attribute.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/filenames.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
@@ -100,7 +109,7 @@ typedef vector<Override> Overrides;
 typedef vector<RepoName> RepoNames;
 
 static void print_help();
-ATTRIBUTE_NONNULL_ static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, Statusline *statusline, string *errtext);
+ATTRIBUTE_NONNULL((1, 2, 3, 8, 9)) static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, const char *deltafile, Statusline *statusline, string *errtext);
 static void error_callback(const string& str);
 ATTRIBUTE_NONNULL_ static void add_pathnames(PathVec *add_list, const WordVec& to_add, bool must_resolve);
 ATTRIBUTE_NONNULL_ static void add_override(Overrides *override_list, EixRc *eixrc, const char *s);
@@ -138,6 +147,10 @@ static void print_help() {
 "\n"
 " -r  --repo-name         set label for matching overlay.\n"
 "\n"
+"     --delta FILE        write a delta from the previous database to FILE.\n"
+"     --apply-delta FILE  apply the delta FILE to the database instead of\n"
+"                         reading the portage tree.\n"
+"\n"
 "This program is covered by the GNU General Public License. See COPYING for\n"
 "further information.")) % program_name % EIX_CACHEFILE;
 }
@@ -147,7 +160,9 @@ enum update_options {
 	O_DUMP_DEFAULTS,
 	O_KNOWN_VARS,
 	O_PRINT_VAR,
-	O_FORCE_STATUS
+	O_FORCE_STATUS,
+	O_DELTA,
+	O_APPLY_DELTA
 };
 
 static bool
@@ -158,7 +173,7 @@ static bool
 	dump_eixrc(false),
 	dump_defaults(false);
 
-static bool use_percentage, use_status, verbose;
+static bool use_percentage, use_status, verbose, trigram_index, fuzzy_index, revdep_index, stability_index;
 
 typedef vector<const char *> ExcludeArgs;
 typedef ExcludeArgs AddArgs;
@@ -172,6 +187,8 @@ static RepoArgs *repo_args;
 
 static const char *outputname = NULLPTR;
 static const char *var_to_print = NULLPTR;
+static const char *delta_output = NULLPTR;
+static const char *delta_input = NULLPTR;
 
 /**
 Arguments and options
@@ -202,6 +219,8 @@ EixUpdateOptionList::EixUpdateOptionList() {
 	push_back(Option("override-method", 'm',    Option::PAIRLIST,   method_args));
 	push_back(Option("repo-name",      'r',     Option::PAIRLIST,   repo_args));
 	push_back(Option("output",         'o',     Option::STRING,     &outputname));
+	push_back(Option("delta",         O_DELTA,  Option::STRING,     &delta_output));
+	push_back(Option("apply-delta", O_APPLY_DELTA, Option::STRING,  &delta_input));
 }
 
 static PercentStatus *reading_percent_status;
@@ -345,6 +364,10 @@ int run_eix_update(int argc, char *argv[]) {
 
 	/* other defaults */
 	verbose = eixrc.getBool("UPDATE_VERBOSE");
+	trigram_index = eixrc.getBool("TRIGRAM_INDEX");
+	fuzzy_index = eixrc.getBool("FUZZY_INDEX");
+	revdep_index = eixrc.getBool("REVDEP_INDEX");
+	stability_index = eixrc.getBool("STABILITY_INDEX");
 
 	/* Setup ArgumentReader. */
 	ArgumentReader argreader(argc, argv, EixUpdateOptionList());
@@ -394,6 +417,29 @@ int run_eix_update(int argc, char *argv[]) {
 		override_umask = false;
 	}
 
+	if(unlikely(delta_input != NULLPTR)) {
+		INFO(_("Applying delta %s to %s...")) % delta_input % outputfile;
+		mode_t old_umask;
+		if(override_umask) {
+			old_umask = umask(2);
+		}
+		string errtext;
+		bool ok(DBDelta::apply_delta(outputfile.c_str(), outputfile.c_str(), delta_input, &errtext));
+		if(override_umask) {
+			umask(old_umask);
+		}
+		if(unlikely(!ok)) {
+			eix::say_error() % errtext;
+			return EXIT_FAILURE;
+		}
+		/* The indices do not belong to the new database */
+		std::remove((outputfile + TrigramIndex::suffix).c_str());
+		std::remove((outputfile + FuzzyIndex::suffix).c_str());
+		std::remove((outputfile + ReverseDependIndex::suffix).c_str());
+		std::remove((outputfile + StabilityIndex::suffix).c_str());
+		return EXIT_SUCCESS;
+	}
+
 	Statusline statusline(use_status, (use_status &&
 		stringstart_in_wordlist(eixrc["TERM"],
 			split_string(eixrc["TERM_SOFTSTATUSLINE"]))),
@@ -543,11 +589,39 @@ int run_eix_update(int argc, char *argv[]) {
 	/* Update the database from scratch */
 	string errtext;
 	if(unlikely(!update(outputfile.c_str(), &table, &portage_settings, override_umask,
-			repo_names, excluded_overlays, &statusline, &errtext))) {
+			repo_names, excluded_overlays, delta_output, &statusline, &errtext))) {
 		eix::say_error() % errtext;
 		statusline.failure();
 		return EXIT_FAILURE;
 	}
+
+	/* The stability index is calculated with the local configuration
+	from the complete database */
+	string indexfile(outputfile + StabilityIndex::suffix);
+	if(stability_index) {
+		INFO(_("Writing stability index %s...")) % indexfile;
+		WordSet files;
+		std::time_t start(std::time(NULLPTR));
+		record_read_files(&files);
+		PortageSettings local_settings(&eixrc, &parse_error, true, false);
+		record_read_files(NULLPTR);
+		mode_t old_umask;
+		if(override_umask) {
+			old_umask = umask(2);
+		}
+		string index_errtext;
+		bool ok(StabilityIndex::write_index(indexfile.c_str(), outputfile.c_str(),
+			&local_settings, files, start, &index_errtext));
+		if(override_umask) {
+			umask(old_umask);
+		}
+		if(unlikely(!ok)) {
+			eix::say_error() % index_errtext;
+			std::remove(indexfile.c_str());
+		}
+	} else {
+		std::remove(indexfile.c_str());
+	}
 	statusline.success();
 	return EXIT_SUCCESS;
 }
@@ -558,7 +632,7 @@ static void error_callback(const string& str) {
 	reading_percent_status->interprint_end();
 }
 
-static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, Statusline *statusline, string *errtext) {
+static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, const char *deltafile, Statusline *statusline, string *errtext) {
 	DBHeader dbheader;
 	WordVec categories;
 	portage_settings->pushback_categories(&categories);
@@ -682,6 +756,22 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 
 	INFO(_("Calculating hash tables..."));
 	Database::prep_header_hashs(&dbheader, package_tree);
+	dbheader.size = package_tree.countCategories();
+	/* The indices recognize the new database by its generation */
+	eix::UNumber generation;
+	dbheader.generation = (Database::read_generation(outputfile, &generation) ?
+		(generation + 1) : 1);
+
+	/* The delta must be written while the previous database still exists */
+	if(deltafile != NULLPTR) {
+		INFO(_("Writing delta file %s...")) % deltafile;
+		if(unlikely(!DBDelta::write_delta(deltafile, outputfile, package_tree, dbheader, errtext))) {
+			/* Keep the previous database so that a later delta can be made,
+			and do not leave an outdated delta */
+			std::remove(deltafile);
+			return false;
+		}
+	}
 
 	/* And write database back to disk... */
 	statusline->print(eix::format(P_("Statusline eix-update", "Creating %s")) % outputfile);
@@ -700,12 +790,67 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 		return false;
 	}
 
-	dbheader.size = package_tree.countCategories();
-
 	if(!(likely(db.write_header(dbheader, errtext)) &&
 		likely(db.write_packagetree(package_tree, dbheader, errtext)))) {
 		return false;
 	}
+	db.destroy();
+
+	/* The indices must be written after the database is complete */
+	string indexfile(outputfile);
+	indexfile.append(TrigramIndex::suffix);
+	if(trigram_index) {
+		INFO(_("Writing trigram index %s...")) % indexfile;
+		if(override_umask) {
+			old_umask = umask(2);
+		}
+		string index_errtext;
+		ok = TrigramIndex::write_index(indexfile.c_str(), outputfile, package_tree, &index_errtext);
+		if(override_umask) {
+			umask(old_umask);
+		}
+		if(unlikely(!ok)) {
+			eix::say_error() % index_errtext;
+		}
+	} else {
+		std::remove(indexfile.c_str());
+	}
+	indexfile.assign(outputfile);
+	indexfile.append(FuzzyIndex::suffix);
+	if(fuzzy_index) {
+		INFO(_("Writing fuzzy index %s...")) % indexfile;
+		if(override_umask) {
+			old_umask = umask(2);
+		}
+		string index_errtext;
+		ok = FuzzyIndex::write_index(indexfile.c_str(), outputfile, package_tree, &index_errtext);
+		if(override_umask) {
+			umask(old_umask);
+		}
+		if(unlikely(!ok)) {
+			eix::say_error() % index_errtext;
+		}
+	} else {
+		std::remove(indexfile.c_str());
+	}
+	indexfile.assign(outputfile);
+	indexfile.append(ReverseDependIndex::suffix);
+	if(revdep_index && Depend::use_depend) {
+		INFO(_("Writing reverse dependency index %s...")) % indexfile;
+		if(override_umask) {
+			old_umask = umask(2);
+		}
+		string index_errtext;
+		ok = ReverseDependIndex::write_index(indexfile.c_str(), outputfile, package_tree, &index_errtext);
+		if(override_umask) {
+			umask(old_umask);
+		}
+		if(unlikely(!ok)) {
+			eix::say_error() % index_errtext;
+		}
+	} else {
+		std::remove(indexfile.c_str());
+	}
 
 	INFO(N_("Database contains %s packages in %s category",
 		"Database contains %s packages in %s categories",
@@ -8,6 +8,9 @@
 //   Martin Väth <martin@mvath.de>
 
 #include <config.h>  // IWYU pragma: keep
+#ifndef PACKAGE_VERSION
+#include <config_vers.h>
+#endif
 
 #include <unistd.h>
 
@@ -15,12 +18,16 @@
 #include <cstring>
 
 #include <algorithm>
+#include <fstream>
+#include <iostream>
 #include <string>
 #include <vector>
 
 #include "database/header.h"
 #include "database/io.h"
 #include "database/package_reader.h"
+#include "database/stability.h"
+#include "database/trigram.h"
 #include "eixTk/ansicolor.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/attribute.h"
@@ -61,6 +68,7 @@
 #include "search/packagetest.h"
 #include "various/cli.h"
 #include "various/drop_permissions.h"
+#include "various/querycache.h"
 
 #define VAR_DB_PKG "/var/db/pkg/"
 
@@ -77,10 +85,13 @@ ATTRIBUTE_NONNULL((1, 2)) static bool print_overlay_table(PrintFormat *fmt, DBHe
 ATTRIBUTE_NONNULL_ static void parseFormat(const char *sourcename, const char *content);
 ATTRIBUTE_NONNULL_ static void set_format(EixRc *rc);
 ATTRIBUTE_NONNULL_ static void setup_defaults(EixRc *rc, bool is_tty);
+ATTRIBUTE_NONNULL_ static int run_eix_query(int argc, char **argv, QueryCache **query_cache);
 ATTRIBUTE_NONNULL_ static bool is_current_dbversion(const char *filename, const char *tooltext);
 static void print_wordvec(const WordVec& vec);
 static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty);
 static void print_removed(const string& dirname, const string& excludefiles, const PackageList& packagelist);
+ATTRIBUTE_NONNULL_ static bool read_batch(WordVec *expressions, const char *filename, bool null_separated);
+ATTRIBUTE_NONNULL_ static void split_batch_line(WordVec *words, const string& line);
 inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist);
 inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist) {
 	print_unused(filename, excludefiles, packagelist, false);
@@ -140,6 +151,11 @@ static void dump_help() {
 "         --cache-file      use another cache-file instead of %s\n"
 "     -R  --remote (toggle)  use remote cache-file %s\n"
 "     -Z  --remote2 (toggle) use remote cache-file %s\n"
+"         --batch FILE      evaluate each line of FILE (- for stdin) as an\n"
+"                           EXPRESSION of its own, reading the database once\n"
+"         --batch-null      the EXPRESSIONs of --batch are separated by NUL\n"
+"         --list-query-cache  list the entries of QUERY_CACHE_DIR\n"
+"         --purge-query-cache remove all entries of QUERY_CACHE_DIR\n"
 "\n"
 "   Output:\n"
 "     -q, --quiet (toggle)   no output. Typically combined with -0\n"
@@ -201,6 +217,10 @@ static void dump_help() {
 "                                     provided by some overlay\n"
 "    --installed-in-overlay OVERLAY   Packages with an installed version\n"
 "                                     provided from OVERLAY\n"
+"    --required-by CATEGORY/NAME      Packages with a version depending on\n"
+"                                     CATEGORY/NAME (needs DEP=true)\n"
+"    --required-by-class CLASSES      Consider only dependencies of CLASSES\n"
+"                                     (e.g. rdepend,pdepend) for --required-by\n"
 "    --restrict-fetch          Match packages with RESTRICT=fetch\n"
 "    --restrict-mirror         Match packages with RESTRICT=mirror\n"
 "    --restrict-primaryuri     Match packages with RESTRICT=primaryuri\n"
@@ -282,6 +302,7 @@ static void dump_help() {
 
 static const char *formatstring;
 static const char *eix_cachefile(NULLPTR);
+static const char *batch_file(NULLPTR);
 static const char *var_to_print(NULLPTR);
 static const char *color(NULLPTR);
 
@@ -347,17 +368,151 @@ static struct LocalOptions {
 		hash_license,
 		hash_depend,
 		print_profile_paths,
-		world_sets;
+		world_sets,
+		batch_null,
+		list_query_cache,
+		purge_query_cache;
 } rc_options;
 
+/**
+Arguments for criteria; these are also used for the expressions of a batch
+**/
+class CriteriaOptionList : public OptionList {
+	public:
+		CriteriaOptionList();
+};
+
 /**
 Arguments and options
 **/
-class EixOptionList : public OptionList {
+class EixOptionList : public CriteriaOptionList {
 	public:
 		EixOptionList();
 };
 
+/**
+Print the matches of an expression one by one, collecting the used overlays
+and observing the limit and the brief options
+**/
+class MatchPrinter {
+	private:
+		DBHeader *header;
+		VarDbPkg *varpkg_db;
+		PortageSettings *portagesettings;
+		const SetStability *stability;
+		PrintFormats *print_formats;
+		eix::Treesize limit;
+		bool reached_limit;
+		PrintFormat::OverlayUsed overlay_used;
+		bool need_overlay_table;
+		PrintFormat::OverlayTranslations overlay_num;
+
+	public:
+		PackageList::size_type count;
+		bool have_printed, over_limit;
+
+		/**
+		Set if no further package should be printed
+		**/
+		bool finished;
+
+		/**
+		Set up the format for the output of the matches
+		**/
+		ATTRIBUTE_NONNULL((2, 3, 4, 5)) MatchPrinter(DBHeader *dbheader, VarDbPkg *vdb, PortageSettings *ps, const SetStability *set_stability, PrintFormats *printformats, MaskList<Mask> *marked_list, eix::Treesize max);
+
+		/**
+		Print p unless overlays are renumbered; collect the used overlays
+		**/
+		ATTRIBUTE_NONNULL_ void package(Package *p);
+
+		/**
+		Print p with the format
+		**/
+		ATTRIBUTE_NONNULL_ void print(Package *p);
+
+		/**
+		Print matches if overlays are renumbered, and print the overlay table
+		@return true if the overlay table was printed
+		**/
+		bool finish(const PackageList& matches);
+};
+
+/**
+An expression with its match tree and its matches
+**/
+class Query {
+	public:
+		/**
+		The expression in batch mode
+		**/
+		std::string expression;
+		MatchTree *matchtree;
+		MaskList<Mask> *marked_list;
+		MatchPrinter *printer;
+		TrigramIndex::PackageSet candidates;
+		bool use_candidates, candidates_installed;
+
+		/**
+		No further matches are needed (because of --brief)
+		**/
+		bool complete;
+
+		/**
+		The matches, unless they are printed immediately.
+		The packages are not owned.
+		**/
+		PackageList matches;
+		PackageList::size_type found;
+
+		/**
+		The Levenshtein distances of the matches for sorting
+		**/
+		FuzzyAlgorithm::LevenshteinMap distances;
+
+		Query(const std::string& expr, bool default_is_or)
+			: expression(expr), matchtree(new MatchTree(default_is_or)),
+			marked_list(NULLPTR), printer(NULLPTR),
+			use_candidates(false), candidates_installed(false),
+			complete(false), found(0) {
+		}
+
+		~Query() {
+			delete printer;
+			delete matchtree;
+			delete marked_list;
+		}
+
+		/**
+		@return false if the package number pkgnum cannot match by the index
+		**/
+		ATTRIBUTE_NONNULL_ bool candidate(eix::Treesize pkgnum, PackageReader *reader, VarDbPkg *varpkg_db) const {
+			return (!use_candidates || (pkgnum >= candidates.size()) ||
+				candidates[pkgnum] ||
+				(candidates_installed && likely(reader->read(PackageReader::NAME)) &&
+					varpkg_db->isInstalled(*(reader->get()))));
+		}
+
+		/**
+		Drop the distance of p which is going to be freed:
+		Its address might be reused by a package which matches otherwise
+		**/
+		void forget(const Package *p) {
+			if(unlikely(!distances.empty())) {
+				distances.erase(p);
+			}
+		}
+};
+
+class Queries : public eix::ptr_container<vector<Query *> > {
+	public:
+		void forget(const Package *p) {
+			for(iterator it(begin()); likely(it != end()); ++it) {
+				it->forget(p);
+			}
+		}
+};
+
 EixOptionList::EixOptionList() {
 	// Global options
 	// The following might give a memory leak with -flto for unknown reasons:
@@ -418,7 +573,13 @@ EixOptionList::EixOptionList() {
 	push_back(Option("cache-file",     O_EIX_CACHEFILE, Option::STRING, &eix_cachefile));
 	push_back(Option("remote",         'R', Option::BOOLEAN, &rc_options.remote));
 	push_back(Option("remote2",        'Z', Option::BOOLEAN, &rc_options.remote2));
+	push_back(Option("batch",          O_BATCH, Option::STRING, &batch_file));
+	push_back(Option("batch-null",     O_BATCH_NULL, Option::BOOLEAN_T, &rc_options.batch_null));
+	push_back(Option("list-query-cache",  O_LIST_QUERY_CACHE,  Option::BOOLEAN_T, &rc_options.list_query_cache));
+	push_back(Option("purge-query-cache", O_PURGE_QUERY_CACHE, Option::BOOLEAN_T, &rc_options.purge_query_cache));
+}
 
+CriteriaOptionList::CriteriaOptionList() {
 	// Options for criteria
 	push_back(Option("installed",     'I'));
 	push_back(Option("multi-installed", 'i'));
@@ -462,6 +623,8 @@ EixOptionList::EixOptionList() {
 	push_back(Option("only-in-overlay",      O_ONLY_OVERLAY,      Option::KEEP_STRING_OPTIONAL));
 	push_back(Option("installed-in-some-overlay", O_INSTALLED_SOME));
 	push_back(Option("installed-in-overlay", O_INSTALLED_OVERLAY, Option::KEEP_STRING_OPTIONAL));
+	push_back(Option("required-by",          O_REQUIRED_BY,       Option::KEEP_STRING));
+	push_back(Option("required-by-class",    O_REQUIRED_BY_CLASS, Option::KEEP_STRING));
 	push_back(Option("restrict-fetch",         O_RESTRICT_FETCH));
 	push_back(Option("restrict-mirror",        O_RESTRICT_MIRROR));
 	push_back(Option("restrict-primaryuri",    O_RESTRICT_PRIMARYURI));
@@ -610,6 +773,94 @@ static bool print_overlay_table(PrintFormat *fmt, DBHeader *header, PrintFormat:
 	return printed_overlay;
 }
 
+MatchPrinter::MatchPrinter(DBHeader *dbheader, VarDbPkg *vdb, PortageSettings *ps, const SetStability *set_stability, PrintFormats *printformats, MaskList<Mask> *marked_list, eix::Treesize max)
+	: header(dbheader), varpkg_db(vdb), portagesettings(ps),
+	stability(set_stability), print_formats(printformats),
+	limit(max), reached_limit(false),
+	overlay_used(dbheader->countOverlays(), false), need_overlay_table(false),
+	overlay_num(dbheader->countOverlays(), 0),
+	count(0), have_printed(false), over_limit(false), finished(false) {
+	format->set_marked_list(marked_list);
+	format->set_overlay_translations(NULLPTR);
+	format->set_overlay_used(&overlay_used, &need_overlay_table);
+}
+
+void MatchPrinter::package(Package *p) {
+	stability->set_stability(p);
+
+	if(unlikely(print_formats != NULLPTR)) {
+		print_formats->package(p);
+		return;
+	}
+
+	if(p->largest_overlay != 0) {
+		need_overlay_table = true;
+		if(overlay_mode <= mode_list_used) {
+			for(Package::iterator ver(p->begin());
+				likely(ver != p->end()); ++ver) {
+				ExtendedVersion::Overlay key(ver->overlay_key);
+				if(key > 0) {
+					overlay_used[key - 1] = true;
+				}
+			}
+		}
+	}
+	if(overlay_mode != mode_list_used_renumbered) {
+		print(p);
+	}
+}
+
+void MatchPrinter::print(Package *p) {
+	if(format->print(p, header, varpkg_db, portagesettings, stability, reached_limit)) {
+		have_printed = true;
+		++count;
+		if(unlikely(reached_limit)) {
+			over_limit = true;
+		} else if(unlikely(count == limit)) {
+			reached_limit = true;
+		}
+		if(unlikely(rc_options.brief || (rc_options.brief2 && count > 1))) {
+			finished = true;
+		}
+	}
+}
+
+bool MatchPrinter::finish(const PackageList& matches) {
+	switch(overlay_mode) {
+		case mode_list_all:
+			need_overlay_table = true;
+			break;
+		case mode_list_none:
+			need_overlay_table = false;
+			break;
+		default:
+			break;
+	}
+	if(overlay_mode == mode_list_used_renumbered) {
+		ExtendedVersion::Overlay i(1);
+		PrintFormat::OverlayUsed::iterator uit(overlay_used.begin());
+		PrintFormat::OverlayTranslations::iterator nit(overlay_num.begin());
+		for(; likely(uit != overlay_used.end()); ++uit, ++nit) {
+			if(*uit == true) {
+				*nit = i++;
+			}
+		}
+		format->set_overlay_translations(&overlay_num);
+		for(PackageList::const_iterator it(matches.begin());
+			likely((it != matches.end()) && !finished); ++it) {
+			print(*it);
+		}
+	}
+	if(need_overlay_table) {
+		if(print_overlay_table(format, header,
+			(overlay_mode <= mode_list_used)? &overlay_used : NULLPTR)) {
+			have_printed = true;
+			return true;
+		}
+	}
+	return false;
+}
+
 static void parseFormat(const char *sourcename, const char *content) {
 	string error_text;
 	if(likely(format->parseFormat(content, &error_text))) {
@@ -650,6 +901,19 @@ static void set_format(EixRc *rc) {
 }
 
 int run_eix(int argc, char** argv) {
+	QueryCache *query_cache(NULLPTR);
+	int status(run_eix_query(argc, argv, &query_cache));
+	if(query_cache != NULLPTR) {
+		query_cache->finish(status);
+		delete query_cache;
+	}
+	return status;
+}
+
+/**
+If the output shall be cached, *query_cache is set to the capturing cache
+**/
+static int run_eix_query(int argc, char **argv, QueryCache **query_cache) {
 	// Initialize static classes
 	Eapi::init_static();
 	Category::init_static();
@@ -784,6 +1048,56 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
+	if(unlikely(rc_options.list_query_cache)) {
+		return (QueryCache::list(eixrc["QUERY_CACHE_DIR"]) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if(unlikely(rc_options.purge_query_cache)) {
+		return (QueryCache::purge(eixrc["QUERY_CACHE_DIR"]) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// The limit depends on the terminal, so it is part of the cache key
+	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
+	eix::Treesize limit(is_tty ? eixrc.getInteger(limit_var) : 0);
+
+	// The key consists of everything which might influence the output
+	// except for the content of files which are read
+	if(unlikely(eixrc.getBool("QUERY_CACHE")) && likely(batch_file == NULLPTR)) {
+		string key(PACKAGE_VERSION), title;
+		key.append(1, '\0');
+		key.append(format->no_color ? "nocolor" : "color");
+		key.append(1, '\0');
+		key.append(eix::format("limit=%s") % limit);
+		key.append(1, '\0');
+		key.append(normalize_path(cachefile.c_str()));
+		for(int i(1); i < argc; ++i) {
+			key.append(1, '\0');
+			key.append(argv[i]);
+			if(i > 1) {
+				title.append(1, ' ');
+			}
+			title.append(argv[i]);
+		}
+		key.append(1, '\0');
+		eixrc.append_values(&key);
+		PortageSettings::append_environment(&key);
+		*query_cache = new QueryCache(eixrc["QUERY_CACHE_DIR"], key, title);
+		QueryCache::Status status;
+		if((*query_cache)->lookup(&status)) {
+			delete *query_cache;
+			*query_cache = NULLPTR;
+			return status;
+		}
+		WordVec watch;
+		watch.PUSH_BACK(cachefile);
+		string installed(eixrc["EPREFIX_INSTALLED"] + VAR_DB_PKG);
+		watch.PUSH_BACK(installed);
+		pushback_files(installed, &watch, NULLPTR, 2, true, true);
+		if(!(*query_cache)->start(watch)) {
+			delete *query_cache;
+			*query_cache = NULLPTR;
+		}
+	}
+
 	bool only_printed;
 
 	if(unlikely(rc_options.xml || rc_options.proto)) {
@@ -820,8 +1134,6 @@ int run_eix(int argc, char** argv) {
 		eixrc.getBool("USE_BUILD_TIME"));
 	varpkg_db.check_installed_overlays = eixrc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
 
-	MaskList<Mask> *marked_list(NULLPTR);
-
 	/* Open database file */
 	Database db;
 	if(unlikely(!opencache(&db, cachefile.c_str(), tooltext))) {
@@ -896,42 +1208,160 @@ int run_eix(int argc, char** argv) {
 
 	SetStability stability(&portagesettings, !rc_options.ignore_etc_portage, false, eixrc.getBool("ALWAYS_ACCEPT_KEYWORDS"));
 
-	MatchTree *matchtree = new MatchTree(eixrc.getBool("DEFAULT_IS_OR"));
-	parse_cli(matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, parse_error, &marked_list, argreader);
+	/* The expression of the command line or the expressions of the batch */
+	Queries queries;
+	bool batch(batch_file != NULLPTR);
+	if(likely(!batch)) {
+		Query *query(new Query("", eixrc.getBool("DEFAULT_IS_OR")));
+		queries.PUSH_BACK(query);
+		parse_cli(query->matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, parse_error, &(query->marked_list), argreader);
+	} else {
+		WordVec expressions;
+		if(unlikely(!read_batch(&expressions, batch_file, rc_options.batch_null))) {
+			eix::say_error(_("cannot read batch file %s")) % batch_file;
+			return EXIT_FAILURE;
+		}
+		for(WordVec::const_iterator it(expressions.begin());
+			likely(it != expressions.end()); ++it) {
+			WordVec words;
+			split_batch_line(&words, *it);
+			if(unlikely(words.empty())) {
+				continue;
+			}
+			vector<const char *> args(1, argv[0]);
+			for(WordVec::const_iterator w(words.begin()); likely(w != words.end()); ++w) {
+				args.PUSH_BACK(w->c_str());
+			}
+			ArgumentReader query_args(static_cast<int>(args.size()), &(args[0]), CriteriaOptionList());
+			Query *query(new Query(*it, eixrc.getBool("DEFAULT_IS_OR")));
+			queries.PUSH_BACK(query);
+			parse_cli(query->matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, parse_error, &(query->marked_list), query_args);
+		}
+	}
+	for(Queries::iterator it(queries.begin()); likely(it != queries.end()); ++it) {
+		it->matchtree->plan();
+	}
+
+	/* Use the trigram and fuzzy indices to skip packages which cannot match */
+	if(likely(!rc_options.test_unused)) {
+		SearchIndex index;
+		if(index.open(cachefile)) {
+			for(Queries::iterator it(queries.begin()); likely(it != queries.end()); ++it) {
+				it->use_candidates = it->matchtree->candidates(&index, &(it->candidates), &(it->candidates_installed));
+			}
+		}
+	}
 
-	PackageList matches;
+	if((overlay_mode == mode_list_used_renumbered) && (header.countOverlays() <= 1)) {
+		// There is nothing to renumber
+		overlay_mode = mode_list_used;
+	}
+	if(rc_options.xml || rc_options.proto || rc_options.be_quiet) {
+		overlay_mode = mode_list_none;
+		rc_options.pure_packages = true;
+	}
+	PrintFormats *print_formats(NULLPTR);
+	if(rc_options.xml) {
+		if (unlikely(rc_options.proto)) {
+			eix::say_error(_("--xml and --proto must not be specified simultaneously"));
+			std::exit(EXIT_FAILURE);
+		}
+		print_formats = new PrintXml(&header, &varpkg_db, format, &stability, &eixrc,
+			portagesettings["PORTDIR"]);
+	} else if (rc_options.proto) {
+		print_formats = new PrintProto(&header, &varpkg_db, format, &stability);
+	}
+	/* Unless the matches must be collected (for several expressions,
+	sorting, renumbering of overlays, or testing for unused entries),
+	each match is printed and freed immediately */
+	bool stream(likely(!batch) && likely(!rc_options.test_unused) &&
+		(overlay_mode != mode_list_used_renumbered) &&
+		likely(!FuzzyAlgorithm::might_sort()));
+	if(likely(stream)) {
+		Query *query(queries.front());
+		query->printer = new MatchPrinter(&header, &varpkg_db, &portagesettings, &stability,
+			print_formats, query->marked_list, limit);
+	}
+
+	/* Use the precalculated local stability if it is still current */
+	StabilityIndex stability_index;
+	bool use_stability_index(!rc_options.ignore_etc_portage &&
+		stability_index.open((cachefile + StabilityIndex::suffix).c_str(),
+			cachefile.c_str(), portagesettings));
+
+	/* Read the database once, matching all expressions */
+	PackageList collected;
 	PackageList all_packages; {
 		PackageReader reader(&db, header, &portagesettings);
+		if(use_stability_index) {
+			reader.set_stability_index(&stability_index);
+		}
 		bool add_rest(false);
-		while(likely(reader.next())) {
+		Queries::size_type complete(0);
+		vector<Query *> matching;
+		for(eix::Treesize pkgnum(0); likely(reader.next()); ++pkgnum) {
 			if(unlikely(add_rest)) {
 				all_packages.PUSH_BACK(reader.release());
-			} else if(unlikely(matchtree->match(&reader))) {
-				Package *release(reader.release());
-				if(unlikely(release == NULLPTR)) {
-					break;
-				}
-				matches.PUSH_BACK(release);
-				if(unlikely(only_printed &&
-					(rc_options.brief ||
-						(rc_options.brief2 && (matches.size() > 1))))) {
-					if(unlikely(rc_options.test_unused)) {
-						add_rest = true;
-					} else {
-						break;
+				continue;
+			}
+			matching.clear();
+			for(Queries::iterator it(queries.begin()); likely(it != queries.end()); ++it) {
+				if(likely(!it->complete) && it->candidate(pkgnum, &reader, &varpkg_db)) {
+					FuzzyAlgorithm::set_levenshtein_map(&(it->distances));
+					if(unlikely(it->matchtree->match(&reader))) {
+						matching.PUSH_BACK(*it);
 					}
 				}
-				if(unlikely(rc_options.test_unused)) {
-					all_packages.PUSH_BACK(release);
-				}
-			} else {
+			}
+			if(likely(matching.empty())) {
 				if(unlikely(rc_options.test_unused)) {
 					Package *release(reader.release());
 					if(unlikely(release == NULLPTR)) {
 						break;
 					}
 					all_packages.PUSH_BACK(release);
-				} else if(unlikely(!reader.skip())) {
+					continue;
+				}
+				queries.forget(reader.get());
+				if(unlikely(!reader.skip())) {
+					break;
+				}
+				continue;
+			}
+			Package *release(reader.release());
+			if(unlikely(release == NULLPTR)) {
+				break;
+			}
+			if(unlikely(rc_options.test_unused)) {
+				all_packages.PUSH_BACK(release);
+			} else if(!stream) {
+				collected.PUSH_BACK(release);
+			}
+			for(vector<Query *>::iterator it(matching.begin()); likely(it != matching.end()); ++it) {
+				Query *query(*it);
+				++(query->found);
+				if(likely(stream)) {
+					if(likely(!query->printer->finished)) {
+						query->printer->package(release);
+					}
+				} else {
+					query->matches.PUSH_BACK(release);
+				}
+				if(unlikely(only_printed &&
+					(rc_options.brief ||
+						(rc_options.brief2 && (query->found > 1))))) {
+					query->complete = true;
+					++complete;
+				}
+			}
+			if(likely(stream)) {
+				queries.forget(release);
+				delete release;
+			}
+			if(unlikely(complete == queries.size())) {
+				if(unlikely(rc_options.test_unused)) {
+					add_rest = true;
+				} else {
 					break;
 				}
 			}
@@ -943,9 +1373,6 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
-	// Delete old matchtree
-	delete matchtree;
-
 	if(unlikely(rc_options.test_unused)) {
 		bool empty(eixrc.getBool("TEST_FOR_EMPTY"));
 		if(likely(eixrc.getBool("TEST_KEYWORDS"))) {
@@ -996,121 +1423,83 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
-	/* Sort the found matches by rating */
-	if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
-		std::sort(matches.begin(), matches.end(), FuzzyAlgorithm::compare);
-	}
-
-	format->set_marked_list(marked_list);
-	if(overlay_mode != mode_list_used_renumbered) {
-		format->set_overlay_translations(NULLPTR);
-	}
-	bool need_overlay_table(false);
-	PrintFormat::OverlayUsed overlay_used(header.countOverlays(), false);
-	format->set_overlay_used(&overlay_used, &need_overlay_table);
-	PackageList::size_type count(0);
-	PrintFormats *print_formats(NULLPTR);
-	if(rc_options.xml || rc_options.proto || rc_options.be_quiet) {
-		overlay_mode = mode_list_none;
-		rc_options.pure_packages = true;
-	}
-	if (!matches.empty()) {
-		if(rc_options.xml) {
-			if (unlikely(rc_options.proto)) {
-				eix::say_error(_("--xml and --proto must not be specified simultaneously"));
-				std::exit(EXIT_FAILURE);
-			}
-			print_formats = new PrintXml(&header, &varpkg_db, format, &stability, &eixrc,
-				portagesettings["PORTDIR"]);
-		} else if (rc_options.proto) {
-			print_formats = new PrintProto(&header, &varpkg_db, format, &stability);
-		}
-		if (print_formats != NULLPTR) {
+	string delimiter;
+	if(unlikely(batch)) {
+		if(print_formats != NULLPTR) {
 			print_formats->start();
+		} else {
+			delimiter = eixrc["BATCH_DELIMITER"];
 		}
 	}
-	bool have_printed(false);
-	bool reached_limit(false), over_limit(false);
-	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
-	eix::Treesize limit(is_tty ? eixrc.getInteger(limit_var) : 0);
-	for(PackageList::iterator it(matches.begin());
-		likely(it != matches.end()); ++it) {
-		stability.set_stability(*it);
-
-		if(unlikely(print_formats != NULLPTR)) {
-			print_formats->package(*it);
-			continue;
+	PackageList::size_type count(0);
+	for(Queries::iterator it(queries.begin()); likely(it != queries.end()); ++it) {
+		Query *query(*it);
+		if(unlikely(batch)) {
+			if(print_formats != NULLPTR) {
+				print_formats->begin_query(query->expression);
+			} else if(!delimiter.empty()) {
+				eix::say("%s %s") % delimiter % query->expression;
+			}
 		}
 
-		if(it->largest_overlay != 0) {
-			need_overlay_table = true;
-			if(overlay_mode <= mode_list_used) {
-				for(Package::iterator ver(it->begin());
-					likely(ver != it->end()); ++ver) {
-					ExtendedVersion::Overlay key(ver->overlay_key);
-					if(key > 0) {
-						overlay_used[key - 1] = true;
-					}
-				}
-			}
+		/* Sort the found matches by rating */
+		FuzzyAlgorithm::set_levenshtein_map(&(query->distances));
+		if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
+			std::sort(query->matches.begin(), query->matches.end(), FuzzyAlgorithm::compare);
 		}
-		if(overlay_mode != mode_list_used_renumbered) {
-			if(format->print(*it, &header, &varpkg_db, &portagesettings, &stability, reached_limit)) {
-				have_printed = true;
-				++count;
-				if(unlikely(reached_limit)) {
-					over_limit = true;
-				} else if(unlikely(count == limit)) {
-					reached_limit = true;
-				}
-				if(unlikely(rc_options.brief || (rc_options.brief2 && count > 1))) {
-					break;
-				}
+		FuzzyAlgorithm::set_levenshtein_map(NULLPTR);
+		query->distances.clear();
+
+		MatchPrinter *printer(query->printer);
+		if(printer == NULLPTR) {
+			printer = query->printer = new MatchPrinter(&header, &varpkg_db, &portagesettings, &stability,
+				print_formats, query->marked_list, limit);
+			for(PackageList::iterator m(query->matches.begin());
+				likely((m != query->matches.end()) && !printer->finished); ++m) {
+				printer->package(*m);
 			}
 		}
-	}
-	switch(overlay_mode) {
-		case mode_list_all:
-			need_overlay_table = true;
-			break;
-		case mode_list_none:
-			need_overlay_table = false;
-			break;
-		default:
-			break;
-	}
-	PrintFormat::OverlayTranslations overlay_num(header.countOverlays(), 0);
-	if(overlay_mode == mode_list_used_renumbered) {
-		ExtendedVersion::Overlay i(1);
-		PrintFormat::OverlayUsed::iterator uit(overlay_used.begin());
-		PrintFormat::OverlayTranslations::iterator nit(overlay_num.begin());
-		for(; likely(uit != overlay_used.end()); ++uit, ++nit) {
-			if(*uit == true) {
-				*nit = i++;
-			}
+		bool printed_overlay(printer->finish(query->matches));
+		bool have_printed(printer->have_printed);
+		if(unlikely(batch) && (print_formats != NULLPTR)) {
+			print_formats->end_query();
 		}
-		format->set_overlay_translations(&overlay_num);
-		for(PackageList::iterator it(matches.begin());
-			likely(it != matches.end()); ++it) {
-			if(format->print(*it, &header, &varpkg_db, &portagesettings, &stability, reached_limit)) {
+
+		PackageList::size_type query_count(only_printed ? printer->count : query->found);
+		count += query_count;
+		eix::SignedBool print_count_always(rc_options.pure_packages ? -1 :
+			eixrc.getBoolText("PRINT_COUNT_ALWAYS", "never"));
+		if(likely(print_count_always >= 0)) {
+			if((print_count_always != 0) || (query_count > 1)) {
 				have_printed = true;
-				++count;
-				if(unlikely(reached_limit)) {
-					over_limit = true;
-				} else if(unlikely(count == limit)) {
-					reached_limit = true;
-				}
-				if(unlikely(rc_options.brief || (rc_options.brief2 && count > 1))) {
-					break;
+				if(printed_overlay) {
+					eix::say_empty();
 				}
+				eix::say("%s%s%s")
+					% format->color_numbertext
+					% (eix::format(N_("Found %s match",
+						"Found %s matches", query_count))
+						% query_count)
+					% format->color_numbertextend;
+			} else if(unlikely(query_count == 0)) {
+				have_printed = true;
+				eix::say("%s%s%s")
+					% format->color_numbertext
+					% _("No matches found")
+					% format->color_numbertextend;
 			}
 		}
-	}
-	bool printed_overlay(false);
-	if(need_overlay_table) {
-		if(print_overlay_table(format, &header,
-			(overlay_mode <= mode_list_used)? &overlay_used : NULLPTR)) {
-			printed_overlay = have_printed = true;
+		if(likely(have_printed)) {
+			eix::print() % format->color_end;
+			if(unlikely(printer->over_limit)) {
+				eix::say(N_(
+				"Only %s match displayed on terminal\n"
+				"Set %s=0 to show all matches",
+				"Only %s matches displayed on terminal\n"
+				"Set %s=0 to show all matches", limit))
+					% limit
+					% limit_var;
+			}
 		}
 	}
 	if(unlikely(print_formats != NULLPTR)) {
@@ -1118,52 +1507,10 @@ int run_eix(int argc, char** argv) {
 		delete print_formats;
 	}
 
-	if(!only_printed) {
-		count = matches.size();
-	}
-	eix::SignedBool print_count_always(rc_options.pure_packages ? -1 :
-		eixrc.getBoolText("PRINT_COUNT_ALWAYS", "never"));
-	if(likely(print_count_always >= 0)) {
-		if((print_count_always != 0) || (count > 1)) {
-			have_printed = true;
-			if(printed_overlay) {
-				eix::say_empty();
-			}
-			eix::say("%s%s%s")
-				% format->color_numbertext
-				% (eix::format(N_("Found %s match",
-					"Found %s matches", count))
-					% count)
-				% format->color_numbertextend;
-		} else if(unlikely(count == 0)) {
-			have_printed = true;
-			eix::say("%s%s%s")
-				% format->color_numbertext
-				% _("No matches found")
-				% format->color_numbertextend;
-		}
-	}
-	if(likely(have_printed)) {
-		eix::print() % format->color_end;
-		if(unlikely(over_limit)) {
-			eix::say(N_(
-			"Only %s match displayed on terminal\n"
-			"Set %s=0 to show all matches",
-			"Only %s matches displayed on terminal\n"
-			"Set %s=0 to show all matches", limit))
-				% limit
-				% limit_var;
-		}
-	}
-
-	// Delete matches (or all_packages, respectively)
-	if(unlikely(rc_options.test_unused)) {
-		all_packages.delete_and_clear();
-		matches.clear();
-	} else {
-		matches.delete_and_clear();
-	}
-	delete marked_list;
+	// Delete the matches (owned by collected or all_packages, respectively)
+	queries.delete_and_clear();
+	collected.delete_and_clear();
+	all_packages.delete_and_clear();
 
 	if(unlikely(!count)) {
 GCC_DIAG_OFF(sign-conversion)
@@ -1178,6 +1525,76 @@ GCC_DIAG_ON(sign-conversion)
 	return EXIT_SUCCESS;
 }  // NOLINT(readability/fn_size)
 
+static bool read_batch(WordVec *expressions, const char *filename, bool null_separated) {
+	std::ifstream file;
+	std::istream *stream(&std::cin);
+	if(std::strcmp(filename, "-") != 0) {
+		file.open(filename);
+		if(unlikely(!file.is_open())) {
+			return false;
+		}
+		stream = &file;
+	}
+	string expression;
+	while(std::getline(*stream, expression, (null_separated ? '\0' : '\n'))) {
+		expressions->PUSH_BACK(expression);
+	}
+	return !stream->bad();
+}
+
+/**
+Split line into words like a shell: Words are separated by spaces which
+can be quoted with '...' or "..." or escaped by a backslash.
+Within "..." a backslash escapes only " and a backslash; outside of quotes
+it escapes only spaces, quotes and a backslash. Other backslashes are kept,
+so that regular expressions need no doubled backslashes.
+**/
+static void split_batch_line(WordVec *words, const string& line) {
+	string word;
+	bool have_word(false);
+	for(string::size_type i(0); likely(i < line.size()); ++i) {
+		char c(line[i]);
+		if(std::strchr(spaces, c) != NULLPTR) {
+			if(have_word) {
+				words->PUSH_BACK(word);
+				word.clear();
+				have_word = false;
+			}
+			continue;
+		}
+		have_word = true;
+		if(c == '\\') {
+			if((i + 1 < line.size()) &&
+				((std::strchr(spaces, line[i + 1]) != NULLPTR) ||
+				(std::strchr("'\"\\", line[i + 1]) != NULLPTR))) {
+				c = line[++i];
+			}
+			word.append(1, c);
+		} else if(c == '\'') {
+			string::size_type end(line.find('\'', i + 1));
+			if(unlikely(end == string::npos)) {
+				end = line.size();
+			}
+			word.append(line, i + 1, end - i - 1);
+			i = end;
+		} else if(c == '"') {
+			for(++i; likely(i < line.size()) && (line[i] != '"'); ++i) {
+				c = line[i];
+				if((c == '\\') && (i + 1 < line.size()) &&
+					((line[i + 1] == '"') || (line[i + 1] == '\\'))) {
+					c = line[++i];
+				}
+				word.append(1, c);
+			}
+		} else {
+			word.append(1, c);
+		}
+	}
+	if(have_word) {
+		words->PUSH_BACK(word);
+	}
+}
+
 static bool opencache(Database *db, const char *filename, const char *tooltext) {
 	if(likely(db->openread(filename))) {
 		return true;
@@ -11,10 +11,12 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <cstdlib>
+#include <cstring>
 
 #include <string>
 #include <vector>
 
+#include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/formated.h"
@@ -26,6 +28,177 @@
 using std::string;
 using std::vector;
 
+ATTRIBUTE_CONST static char ascii_lower(char c);
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static const char *skip_bracket(const char *p);
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static const char *skip_group(const char *p);
+ATTRIBUTE_NONNULL_ static void end_run(string *literal, string *curr);
+
+static char ascii_lower(char c) {
+	if((c >= 'A') && (c <= 'Z')) {
+		return static_cast<char>(c - 'A' + 'a');
+	}
+	return c;
+}
+
+/**
+@arg p points behind the opening '[' of a bracket expression
+@return the position behind the closing ']' or NULLPTR if there is none
+**/
+static const char *skip_bracket(const char *p) {
+	if(*p == '^') {
+		++p;
+	}
+	if(*p == ']') {
+		++p;
+	}
+	for(; *p != '\0'; ++p) {
+		if(*p == ']') {
+			return p + 1;
+		}
+		if((*p == '[') && ((p[1] == ':') || (p[1] == '=') || (p[1] == '.'))) {
+			const char delim(p[1]);
+			for(p += 2; (*p != '\0') && ((*p != delim) || (p[1] != ']')); ++p) {
+			}
+			if(*p == '\0') {
+				return NULLPTR;
+			}
+			++p;
+		}
+	}
+	return NULLPTR;
+}
+
+/**
+@arg p points behind the opening '(' of a group
+@return the position behind the matching ')' or NULLPTR if there is none
+**/
+static const char *skip_group(const char *p) {
+	for(unsigned int depth(1); *p != '\0'; ) {
+		switch(*(p++)) {
+			case '(':
+				++depth;
+				break;
+			case ')':
+				if(--depth == 0) {
+					return p;
+				}
+				break;
+			case '[':
+				if(unlikely((p = skip_bracket(p)) == NULLPTR)) {
+					return NULLPTR;
+				}
+				break;
+			case '\\':
+				if(unlikely(*(p++) == '\0')) {
+					return NULLPTR;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return NULLPTR;
+}
+
+static void end_run(string *literal, string *curr) {
+	if(curr->size() > literal->size()) {
+		literal->swap(*curr);
+	}
+	curr->clear();
+}
+
+/**
+The parser is conservative: Everything which is not an ordinary character
+outside of groups and bracket expressions just ends the current run, and
+a top-level alternative means that no literal is required at all.
+Non-ASCII characters also end the run, since a quantifier might refer to
+a multibyte character.
+**/
+void Regex::required_literal(string *literal, const char *regex, bool icase) {
+	literal->clear();
+	string curr;
+	for(const char *p(regex); *p != '\0'; ) {
+		char c(*(p++));
+		switch(c) {
+			case '|':
+				literal->clear();
+				return;
+			case '{':
+				if(unlikely((p = std::strchr(p, '}')) == NULLPTR)) {
+					literal->clear();
+					return;
+				}
+				++p;
+				ATTRIBUTE_FALLTHROUGH
+			case '*':
+			case '?':
+				// The previous character is optional
+				if(!curr.empty()) {
+					curr.erase(curr.size() - 1);
+				}
+				end_run(literal, &curr);
+				continue;
+			case '(':
+				p = skip_group(p);
+				break;
+			case '[':
+				p = skip_bracket(p);
+				break;
+			case '\\':
+				c = *(p++);
+				if(unlikely(c == '\0')) {
+					literal->clear();
+					return;
+				}
+				if(std::strchr(".[]()*+?{}|^$\\", c) != NULLPTR) {
+					curr.append(1, c);
+					continue;
+				}
+				// GNU extensions like \w or back references
+				break;
+			default:
+				if(likely((c & 0x80) == 0) && (std::strchr(".+^$)", c) == NULLPTR)) {
+					curr.append(1, (icase ? ascii_lower(c) : c));
+					continue;
+				}
+				break;
+		}
+		end_run(literal, &curr);
+		if(unlikely(p == NULLPTR)) {
+			literal->clear();
+			return;
+		}
+	}
+	end_run(literal, &curr);
+}
+
+/**
+For REG_ICASE only ASCII case folding is applied. Since the locale might
+have more exotic case mappings, strings containing non-ASCII characters
+are never rejected in this case.
+**/
+bool Regex::prefilter(const char *s) const {
+	if(likely(!m_icase)) {
+		return (std::strstr(s, m_literal.c_str()) != NULLPTR);
+	}
+	const char *lit(m_literal.c_str());
+	for(; *s != '\0'; ++s) {
+		if(unlikely((*s & 0x80) != 0)) {
+			return true;
+		}
+		if(ascii_lower(*s) != *lit) {
+			continue;
+		}
+		const char *l(lit + 1);
+		for(const char *t(s + 1); (*l != '\0') && (ascii_lower(*t) == *l); ++t, ++l) {
+		}
+		if(*l == '\0') {
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
 Free the regular expression
 **/
@@ -56,6 +229,8 @@ void Regex::compile(const char *regex, int eflags) {
 		std::exit(EXIT_FAILURE);
 	}
 	m_compiled = true;
+	m_icase = ((eflags & REG_ICASE) != 0);
+	required_literal(&m_literal, regex, m_icase);
 }
 
 /**
@@ -63,7 +238,13 @@ void Regex::compile(const char *regex, int eflags) {
 @return true if the regular expression matches
 **/
 bool Regex::match(const char *s) const {
-	return (!m_compiled) || (!regexec(get(), s, 0, NULLPTR, 0));
+	if(!m_compiled) {
+		return true;
+	}
+	if(!m_literal.empty() && !prefilter(s)) {
+		return false;
+	}
+	return !regexec(get(), s, 0, NULLPTR, 0);
 }
 
 /**
@@ -83,7 +264,8 @@ bool Regex::match(const char *s, string::size_type *b, string::size_type *e) con
 		}
 		return true;
 	}
-	if(regexec(get(), s, 1, pmatch, 0)) {
+	if((!m_literal.empty() && !prefilter(s)) ||
+		regexec(get(), s, 1, pmatch, 0)) {
 		if(likely(b != NULLPTR)) {
 			*b = string::npos;
 		}
@@ -38,20 +38,20 @@ class Regex {
 		/**
 		Initalize class
 		**/
-		Regex() : m_compiled(false) {
+		Regex() : m_compiled(false), m_icase(false) {
 		}
 
 		/**
 		Initalize and compile regular expression
 		**/
-		Regex(const char *regex, int eflags) : m_compiled(false) {
+		Regex(const char *regex, int eflags) : m_compiled(false), m_icase(false) {
 			compile(regex, eflags);
 		}
 
 		/**
 		Initalize and compile regular expression
 		**/
-		explicit Regex(const char *regex) : m_compiled(false) {
+		explicit Regex(const char *regex) : m_compiled(false), m_icase(false) {
 			compile(regex, REG_EXTENDED);
 		}
 
@@ -90,6 +90,13 @@ class Regex {
 			return m_compiled;
 		}
 
+		/**
+		@return the literal which must occur in every match (or empty)
+		**/
+		const std::string& literal() const {
+			return m_literal;
+		}
+
 	protected:
 		/**
 		Get the internal regular expression structure
@@ -107,6 +114,29 @@ class Regex {
 		Is the regex already compiled and nonempty?
 		**/
 		bool m_compiled;
+
+		/**
+		A literal which must occur in every match (lowercase if m_icase).
+		It is used to reject most strings without calling regexec.
+		**/
+		std::string m_literal;
+
+		/**
+		Was the regex compiled with REG_ICASE?
+		**/
+		bool m_icase;
+
+		/**
+		Set literal to the longest literal which must occur in every match
+		of the extended regular expression regex, or to an empty string if
+		no such literal can be determined safely.
+		**/
+		ATTRIBUTE_NONNULL_ static void required_literal(std::string *literal, const char *regex, bool icase);
+
+		/**
+		@return false if s cannot match since m_literal does not occur
+		**/
+		ATTRIBUTE_NONNULL_ bool prefilter(const char *s) const;
 };
 
 class RegexList {
@@ -0,0 +1,38 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "eixTk/sharedstring.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/unordered_set.h"
+
+using std::string;
+
+typedef UNORDERED_SET<string> SharedStringPool;
+
+static SharedStringPool *pool();
+
+/**
+The pool is never destructed, since SharedStrings might be used in
+destructors of static objects. Its nodes are never moved, so the
+pointers to its entries stay valid.
+**/
+static SharedStringPool *pool() {
+	static SharedStringPool *the_pool(new SharedStringPool);
+	return the_pool;
+}
+
+const string *SharedString::empty_string() {
+	static const string *empty(intern(string()));
+	return empty;
+}
+
+const string *SharedString::intern(const string& s) {
+	return &(*(pool()->insert(s).first));
+}
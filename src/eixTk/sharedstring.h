@@ -0,0 +1,123 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_SHAREDSTRING_H_
+#define SRC_EIXTK_SHAREDSTRING_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+/**
+A string stored in a process-wide pool: All equal SharedStrings point
+to the same immutable storage, so copying and comparing them only
+handles a pointer. Strings are never removed from the pool; this is
+meant for strings with few distinct values like categories, slots,
+or repository names.
+**/
+class SharedString {
+	public:
+		SharedString() : m_str(empty_string()) {
+		}
+
+		explicit SharedString(const std::string& s) : m_str(intern(s)) {
+		}
+
+		explicit SharedString(const char *s) : m_str(intern(s)) {
+		}
+
+		SharedString& operator=(const std::string& s) {
+			m_str = intern(s);
+			return *this;
+		}
+
+		SharedString& operator=(const char *s) {
+			m_str = intern(s);
+			return *this;
+		}
+
+		const std::string& str() const {
+			return *m_str;
+		}
+
+		operator const std::string&() const {
+			return *m_str;
+		}
+
+		const char *c_str() const {
+			return m_str->c_str();
+		}
+
+		bool empty() const {
+			return m_str->empty();
+		}
+
+		std::string::size_type size() const {
+			return m_str->size();
+		}
+
+		void clear() {
+			m_str = empty_string();
+		}
+
+		int compare(const std::string& s) const {
+			return m_str->compare(s);
+		}
+
+		bool operator==(const SharedString& s) const {
+			return (m_str == s.m_str);
+		}
+
+		bool operator!=(const SharedString& s) const {
+			return (m_str != s.m_str);
+		}
+
+	private:
+		const std::string *m_str;
+
+		static const std::string *empty_string();
+
+		static const std::string *intern(const std::string& s);
+};
+
+inline static bool operator==(const SharedString& a, const std::string& b) {
+	return (a.str() == b);
+}
+
+inline static bool operator==(const std::string& a, const SharedString& b) {
+	return (a == b.str());
+}
+
+inline static bool operator!=(const SharedString& a, const std::string& b) {
+	return (a.str() != b);
+}
+
+inline static bool operator!=(const std::string& a, const SharedString& b) {
+	return (a != b.str());
+}
+
+inline static bool operator<(const SharedString& a, const SharedString& b) {
+	return (a.str() < b.str());
+}
+
+inline static std::string operator+(const SharedString& a, const std::string& b) {
+	return (a.str() + b);
+}
+
+inline static std::string operator+(const SharedString& a, const char *b) {
+	return (a.str() + b);
+}
+
+inline static std::string operator+(const std::string& a, const SharedString& b) {
+	return (a + b.str());
+}
+
+inline static std::string operator+(const char *a, const SharedString& b) {
+	return (a + b.str());
+}
+
+#endif  // SRC_EIXTK_SHAREDSTRING_H_
@@ -44,8 +44,6 @@ const char *spaces(" \t\r\n");
 const char *shellspecial(" \t\r\n\"'`${}()[]<>?*~;|&#");
 const char *doublequotes("\"$\\");
 
-StringHash *StringHash::comparison_this;
-
 locale localeC("C");
 
 ATTRIBUTE_NONNULL_ static void erase_escapes(string *s, const char *at);
@@ -627,16 +625,37 @@ void StringHash::hash_words(const WordVec& v) {
 }
 
 StringHash::size_type StringHash::get_index(const string& s) const {
+	StringHash::size_type i;
+	if(unlikely(!find_index(s, &i))) {
+		eix::say_error(_("internal error: trying to shortcut non-hashed string"));
+		std::exit(EXIT_FAILURE);
+	}
+	return i;
+}
+
+bool StringHash::find_index(const string& s, StringHash::size_type *index) const {
 	if(!finalized) {
 		eix::say_error(_("internal error: index required before sorting"));
 		std::exit(EXIT_FAILURE);
 	}
 	StrSizeMap::const_iterator i(str_map.find(s));
 	if(i == str_map.end()) {
-		eix::say_error(_("internal error: trying to shortcut non-hashed string"));
-		std::exit(EXIT_FAILURE);
+		return false;
+	}
+	*index = i->second;
+	return true;
+}
+
+void StringHash::make_index() {
+	finalize();
+	if(hashing) {
+		return;
+	}
+	str_map.clear();
+	size_type i(0);
+	for(const_iterator it(begin()); likely(it != end()); ++it) {
+		str_map[*it] = i++;
 	}
-	return i->second;
 }
 
 const string& StringHash::operator[](StringHash::size_type i) const {
@@ -677,8 +696,15 @@ void StringHash::output_depends() const {
 	}
 }
 
-bool StringHash::frequency_comparison(const string a, const string b) {
-	return ((comparison_this->str_map)[b] < (comparison_this->str_map)[a]);
+/**
+More frequent strings first; equally frequent strings are sorted to
+make the result independent of the order of hashing
+**/
+bool StringHash::frequency_comparison(const StrSizeMap::value_type *a, const StrSizeMap::value_type *b) {
+	if(a->second != b->second) {
+		return (b->second < a->second);
+	}
+	return (a->first < b->first);
 }
 
 void StringHash::finalize() {
@@ -689,13 +715,19 @@ void StringHash::finalize() {
 	if(!hashing) {
 		return;
 	}
-	make_vector(this, str_map);
-	comparison_this = this;
-	sort(begin(), end(), StringHash::frequency_comparison);
+	Entries entries;
+	entries.reserve(str_map.size());
+	for(StrSizeMap::iterator it(str_map.begin()); likely(it != str_map.end()); ++it) {
+		entries.PUSH_BACK(&*it);
+	}
+	std::sort(entries.begin(), entries.end(), StringHash::frequency_comparison);
 	// For get_index(), we use str_map as the index map
+	clear();
+	reserve(entries.size());
 	size_type i(0);
-	for(const_iterator it(begin()); likely(it != end()); ++it) {
-		str_map[*it] = i++;
+	for(Entries::const_iterator it(entries.begin()); likely(it != entries.end()); ++it) {
+		PUSH_BACK((*it)->first);
+		(*it)->second = i++;
 	}
 }
 
@@ -470,6 +470,17 @@ class StringHash : public WordVec {
 
 		StringHash::size_type get_index(const std::string& s) const;
 
+		/**
+		@return false if s is not contained in the hash
+		**/
+		ATTRIBUTE_NONNULL_ bool find_index(const std::string& s, StringHash::size_type *index) const;
+
+		/**
+		Make get_index() and find_index() usable also for a hash
+		which was filled with store_string()
+		**/
+		void make_index();
+
 		void output() const;
 		void output_depends() const;
 
@@ -479,8 +490,8 @@ class StringHash : public WordVec {
 		bool hashing, finalized;
 		typedef UNORDERED_MAP<std::string, StringHash::size_type> StrSizeMap;
 		StrSizeMap str_map;
-		static StringHash *comparison_this;
-		static bool frequency_comparison(const std::string a, const std::string b);
+		typedef std::vector<StrSizeMap::value_type *> Entries;
+		ATTRIBUTE_NONNULL_ static bool frequency_comparison(const StrSizeMap::value_type *a, const StrSizeMap::value_type *b);
 };
 
 // Implementation of the templates:
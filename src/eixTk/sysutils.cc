@@ -10,6 +10,7 @@
 #include "eixTk/sysutils.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <fcntl.h>
 #include <grp.h>
 #include <pwd.h>
 // unistd.h is needed on Solaris for including stropts.h, see below
@@ -127,6 +128,20 @@ bool get_mtime(std::time_t *t, const char *file) {
 	return true;
 }
 
+#ifdef HAVE_POSIX_FADVISE
+void prefetch_file(const char *file) {
+	int fd(open(file, O_RDONLY | O_NONBLOCK));
+	if(fd < 0) {
+		return;
+	}
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+}
+#else
+void prefetch_file(const char * /* file */) {
+}
+#endif
+
 /**
 @return mydate formatted according to locales and dateFormat
 **/
@@ -49,6 +49,12 @@ ATTRIBUTE_NONNULL_ bool is_file(const char *file);
 **/
 ATTRIBUTE_NONNULL_ bool is_pure_file(const char *file);
 
+/**
+Tell the system that file will be read soon, so that it can be fetched
+in the background while other files are read
+**/
+ATTRIBUTE_NONNULL_ void prefetch_file(const char *file);
+
 /**
 @return true if mtime of file can be read
 **/
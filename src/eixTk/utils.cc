@@ -20,6 +20,7 @@
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 
 #include <algorithm>
 #include <fstream>
@@ -61,10 +62,33 @@ class Directory {
 		}
 };
 
+static WordSet *recorded_files = NULLPTR;
+
 ATTRIBUTE_NONNULL((1, 2)) static bool pushback_lines_file(const char *file, WordVec *v, bool keep_empty, eix::SignedBool keep_comments, string *errtext);
 static int pushback_files_selector(SCANDIR_ARG3 dir_entry);
 
+void record_read_files(WordSet *files) {
+	recorded_files = files;
+}
+
+void note_read_file(const char *file) {
+	if(unlikely(recorded_files != NULLPTR)) {
+		recorded_files->INSERT(file);
+	}
+}
+
+std::time_t file_signature(string *sig, const string& file) {
+	struct stat st;
+	if(stat(file.c_str(), &st) != 0) {
+		sig->assign("-");
+		return 0;
+	}
+	*sig = eix::format("%s %s %s") % st.st_ino % st.st_size % st.st_mtime;
+	return st.st_mtime;
+}
+
 bool scandir_cc(const string& dir, WordVec *namelist, select_dirent select, bool sorted) {
+	note_read_file(dir.c_str());
 	namelist->clear(); {
 		Directory my_dir;
 		if(!my_dir.opendirectory(dir.c_str())) {
@@ -90,6 +114,7 @@ push_back every line of file into v.
 **/
 static bool pushback_lines_file(const char *file, LineVec *v, bool keep_empty, eix::SignedBool keep_comments, string *errtext) {
 	string line;
+	note_read_file(file);
 	std::ifstream ifstr(file);
 	if(unlikely(!ifstr.is_open())) {
 		if(errtext != NULLPTR) {
@@ -12,6 +12,8 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <ctime>
+
 #include <string>
 
 #include "eixTk/attribute.h"
@@ -35,6 +37,26 @@ inline static bool scandir_cc(const std::string& dir, WordVec *namelist, select_
 	return scandir_cc(dir, namelist, select, true);
 }
 
+/**
+Record the names of all files and directories which are subsequently read
+by pushback_lines(), scandir_cc(), or VarsReader in *files (also if they
+do not exist). NULLPTR stops recording.
+**/
+void record_read_files(WordSet *files);
+
+/**
+Add file to the recorded files if recording is active
+**/
+ATTRIBUTE_NONNULL_ void note_read_file(const char *file);
+
+/**
+Set *sig to inode, size, and mtime of file; "-" means that the file does
+not exist. A file modified in the second of its mtime might be modified
+again without a change of its signature.
+@return the mtime of file or 0
+**/
+ATTRIBUTE_NONNULL_ std::time_t file_signature(std::string *sig, const std::string& file);
+
 /**
 push_back every line of file or dir into v.
 **/
@@ -66,6 +66,14 @@ Move to next input and check for end of buffer
 			STOP; \
 	} while(0)
 
+/**
+Move to the first character of stops and check for end of buffer
+**/
+#define SKIP_TO(stops) do { \
+		if(unlikely((x = find_stop(x, filebuffer_end, stops)) == filebuffer_end)) \
+			STOP; \
+	} while(0)
+
 #define SKIP_SPACE do { \
 		while((INPUT == '\t') || (INPUT == ' ')) NEXT_INPUT; \
 	} while(0)
@@ -101,6 +109,18 @@ Check value-buffer for overrun and push c into the current value-buffer
 		value.append(&(c), 1); \
 	} while(0)
 
+/**
+Push INPUT and all following characters up to the first character of stops
+into the current value-buffer
+**/
+#define VALUE_APPEND_RUN(stops) do { \
+		const char *run_end(find_stop(x + 1, filebuffer_end, stops)); \
+		value.append(x, static_cast<string::size_type>(run_end - x)); \
+		x = run_end; \
+		if(INPUT_EOF) \
+			CHSTATE(EVAL_READ); \
+	} while(0)
+
 /**
 Reset value pointer
 **/
@@ -126,6 +146,24 @@ const VarsReader::Flags
 	VarsReader::HAVE_READ,
 	VarsReader::ONLY_HAVE_READ;
 
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static const char *find_stop(const char *begin, const char *end, const char *stops);
+
+/**
+@return the first position in [begin, end) containing a character of stops
+or end if there is none. The characters are searched by memchr (which is
+vectorized in common libc implementations), narrowing the range with every
+hit; so the most bounding stop (e.g. '\n') should come first.
+**/
+static const char *find_stop(const char *begin, const char *end, const char *stops) {
+	for(; *stops != '\0'; ++stops) {
+		const void *found(std::memchr(begin, *stops, static_cast<size_t>(end - begin)));
+		if(found != NULLPTR) {
+			end = static_cast<const char *>(found);
+		}
+	}
+	return end;
+}
+
 // ************************************************************************
 // ********************* FSM states begin here ****************************
 
@@ -136,7 +174,7 @@ Read until '\n' '#' '\\' '\'' '"'
 '\n' -> [RV] (and check if we are at EOF, EOF's only occur after a newline) -> JUMP_WHITESPACE
 **/
 void VarsReader::JUMP_NOISE() {
-	while(likely(INPUT != '#' && INPUT != '\n' && INPUT != '\'' && INPUT != '"' && INPUT != '\\')) NEXT_INPUT;
+	SKIP_TO("\n#'\"\\");
 	switch(INPUT) {
 		case '#':   NEXT_INPUT;
 		            CHSTATE(JUMP_COMMENT);
@@ -195,9 +233,7 @@ Jump comments.
 Read until the next '\n' comes in. Then move to JUMP_NOISE.
 **/
 void VarsReader::JUMP_COMMENT() {
-	while(likely(INPUT != '\n')) {
-		NEXT_INPUT;
-	}
+	SKIP_TO("\n");
 	CHSTATE(JUMP_NOISE);
 }
 
@@ -438,8 +474,7 @@ If the value ends, EVAL_READ is called.
 **/
 void VarsReader::VALUE_SINGLE_QUOTE() {
 	while(likely((INPUT != '\'') && (INPUT != '\\'))) {
-		VALUE_APPEND(INPUT);
-		NEXT_INPUT_EVAL;
+		VALUE_APPEND_RUN("'\\");
 	}
 	switch(INPUT) {
 		case '\'':  NEXT_INPUT_EVAL;
@@ -473,10 +508,10 @@ void VarsReader::VALUE_SINGLE_QUOTE_PORTAGE() {
 		}
 		if(unlikely(INPUT == '\n')) {
 			VALUE_APPEND(ESC_SP);
-		} else {
-			VALUE_APPEND(INPUT);
+			NEXT_INPUT_EVAL;
+			continue;
 		}
-		NEXT_INPUT_EVAL;
+		VALUE_APPEND_RUN("\n'\\$%");
 	}
 	switch(INPUT) {
 		case '\'':
@@ -503,8 +538,7 @@ void VarsReader::VALUE_DOUBLE_QUOTE() {
 			}
 			continue;
 		}
-		VALUE_APPEND(INPUT);
-		NEXT_INPUT_EVAL;
+		VALUE_APPEND_RUN("\"\\$");
 	}
 	switch(INPUT) {
 		case '"':  NEXT_INPUT_EVAL;
@@ -538,10 +572,10 @@ void VarsReader::VALUE_DOUBLE_QUOTE_PORTAGE() {
 		}
 		if(unlikely(INPUT == '\n')) {
 			VALUE_APPEND(ESC_SP);
-		} else {
-			VALUE_APPEND(INPUT);
+			NEXT_INPUT_EVAL;
+			continue;
 		}
-		NEXT_INPUT_EVAL;
+		VALUE_APPEND_RUN("\n\"\\$%");
 	}
 	switch(INPUT) {
 		case '"':
@@ -886,9 +920,7 @@ Read while INPUT is not in [\\'].
 '\\' -> [RV] NOISE_SINGLE_QUOTE_ESCAPE | '\'' -> [RV] JUMP_NOISE
 **/
 void VarsReader::NOISE_SINGLE_QUOTE() {
-	while(INPUT != '\'' && INPUT != '\\') {
-		NEXT_INPUT;
-	}
+	SKIP_TO("'\\");
 	switch(INPUT) {
 		case '\'':  NEXT_INPUT;
 		            CHSTATE(JUMP_NOISE);
@@ -903,9 +935,7 @@ Read while INPUT is not in [\\"].
 '\\' -> [RV] [RV] | '"' -> [RV] JUMP_NOISE
 **/
 void VarsReader::NOISE_DOUBLE_QUOTE() {
-	while(INPUT != '"' && INPUT != '\\') {
-		NEXT_INPUT;
-	}
+	SKIP_TO("\"\\");
 	switch(INPUT) {
 		case '"':   NEXT_INPUT;
 		            CHSTATE(JUMP_NOISE);
@@ -1063,6 +1093,7 @@ bool VarsReader::read(const char *filename, string *errtext, bool noexist_ok, Wo
 			return true;
 		}
 	}
+	note_read_file(filename);
 	int fd(open(filename, O_RDONLY));
 	if(fd == -1) {
 		if(noexist_ok) {
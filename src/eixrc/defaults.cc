@@ -367,6 +367,32 @@ AddOption(BOOLEAN, "REQUIRED_USE",
 	REQUIRED_USE_DEFAULT, P_("REQUIRED_USE",
 	"If true, store/use REQUIRED_USE. Usage increases disk/memory requirements."));
 
+AddOption(BOOLEAN, "TRIGRAM_INDEX",
+	"false", P_("TRIGRAM_INDEX",
+	"If true, eix-update writes a trigram index of names, descriptions, homepages,\n"
+	"licenses, SRC_URI, and dependencies to the database file with suffix .trigram.\n"
+	"eix uses this index (if it is current) to read only candidate packages\n"
+	"for searches in these fields."));
+
+AddOption(BOOLEAN, "FUZZY_INDEX",
+	"false", P_("FUZZY_INDEX",
+	"If true, eix-update writes a BK-tree of the package names to the database\n"
+	"file with suffix .fuzzy. eix uses this index (if it is current) to read only\n"
+	"candidate packages for fuzzy searches in names."));
+
+AddOption(BOOLEAN, "REVDEP_INDEX",
+	"false", P_("REVDEP_INDEX",
+	"If true and DEP is true, eix-update writes an index of reverse dependencies\n"
+	"to the database file with suffix .revdep. eix uses this index (if it is\n"
+	"current) to read only candidate packages for --required-by."));
+
+AddOption(BOOLEAN, "STABILITY_INDEX",
+	"false", P_("STABILITY_INDEX",
+	"If true, eix-update calculates the mask and keyword flags resulting from\n"
+	"/etc/portage for all versions and writes them to the database file with\n"
+	"suffix .stability. eix uses these flags as long as the database and all\n"
+	"configuration files and settings consulted for them are unchanged."));
+
 AddOption(STRING, "DEFAULT_FORMAT",
 	"normal", P_("DEFAULT_FORMAT",
 	"Defines whether --compact or --verbose is on by default."));
@@ -376,6 +402,20 @@ AddOption(STRING, "PRINT_COUNT_ALWAYS",
 	"Allowed values are true/false/never.\n"
 	"If true, always print the number of matches (even 0 or 1) in the last line."));
 
+AddOption(STRING, "BATCH_DELIMITER",
+	"###", P_("BATCH_DELIMITER",
+	"With --batch, this string and the expression are printed before the\n"
+	"matches of each expression (unless empty or with --xml or --proto)."));
+
+AddOption(BOOLEAN, "QUERY_CACHE",
+	"false", P_("QUERY_CACHE",
+	"If true, the output of eix is stored in QUERY_CACHE_DIR and reused for\n"
+	"the same query as long as the database and all files read are unchanged."));
+
+AddOption(STRING, "QUERY_CACHE_DIR",
+	"%{EPREFIX}/var/cache/eix/queries", P_("QUERY_CACHE_DIR",
+	"The directory for the entries of QUERY_CACHE. Its parent must exist."));
+
 AddOption(BOOLEAN, "NOCOLORS",
 	"%{NOCOLOR}", P_("NOCOLORS",
 	"Do not output colors."));
@@ -493,6 +533,11 @@ AddOption(STRING, "OVERRIDE_CACHE_METHOD",
 	"This variable can override the choices of CACHE_METHOD,\n"
 	"and in addition it can override the choices made by KEEP_VIRTUALS."));
 
+AddOption(INTEGER, "EBUILD_JOBS",
+	"1", P_("EBUILD_JOBS",
+	"The maximal number of ebuild processes which the cache methods ebuild*\n"
+	"and (with EBUILD_PORTAGE3_0_24) ebuild run in parallel."));
+
 AddOption(STRING, "EBUILD_PORTAGE3_0_24",
 	"true", P_("EBUILD_PORTAGE3_0_24",
 	"Must be true if and only if cache methods ebuild and ebuild* are to be used\n"
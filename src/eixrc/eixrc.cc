@@ -777,6 +777,16 @@ string EixRc::as_comment(const string& s) {
 	return ret;
 }
 
+void EixRc::append_values(string *s) const {
+	WordIterateMap sorted(main_map.begin(), main_map.end());
+	for(WordIterateMap::const_iterator it(sorted.begin()); likely(it != sorted.end()); ++it) {
+		s->append(it->first);
+		s->append(1, '=');
+		s->append(it->second);
+		s->append(1, '\0');
+	}
+}
+
 void EixRc::dumpDefaults(FILE *s, bool use_defaults) {
 	string message(use_defaults ?
 		_("was locally changed to:") :
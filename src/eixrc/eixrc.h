@@ -84,6 +84,11 @@ class EixRc {
 
 		ATTRIBUTE_NONNULL_ void dumpDefaults(FILE *s, bool use_defaults);
 
+		/**
+		Append all variables and their values (sorted) to *s
+		**/
+		ATTRIBUTE_NONNULL_ void append_values(std::string *s) const;
+
 		ATTRIBUTE_PURE const char *cstr(const std::string& key) const;
 
 		ATTRIBUTE_PURE const char *prefix_cstr(const std::string& key) const;
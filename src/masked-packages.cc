@@ -9,6 +9,7 @@
 
 #include <sys/types.h>
 
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
@@ -46,6 +47,9 @@ static void print_help() {
 " -m, --mask MASK          add MASK to the list of masks\n"
 " -f, --file FILENAME      add masks from file FILENAME.\n"
 " -F, --read-file FILENAME read args as words from file FILENAME.\n"
+" -s, --stream (toggle)    after the other args, read args as words from\n"
+"                          standard input and test them while reading.\n"
+"                          Then -f and -F cannot read standard input.\n"
 "Directories are read recursively.\n"
 "An empty/omitted filename means standard input.\n"
 "\n"
@@ -60,6 +64,7 @@ static struct {
 	bool
 		be_quiet,
 		no_warn,
+		stream,
 		help;
 } rc_options;
 
@@ -75,11 +80,14 @@ MaskedOptionList::MaskedOptionList() {
 	EMPLACE_BACK(Option, ("help",      'h', Option::BOOLEAN, &rc_options.help));
 	EMPLACE_BACK(Option, ("quiet",     'q', Option::BOOLEAN, &rc_options.be_quiet));
 	EMPLACE_BACK(Option, ("nowarn",    'Q', Option::BOOLEAN, &rc_options.no_warn));
+	EMPLACE_BACK(Option, ("stream",    's', Option::BOOLEAN, &rc_options.stream));
 	EMPLACE_BACK(Option, ("file",      'f', Option::KEEP_STRING_OPTIONAL));
 	EMPLACE_BACK(Option, ("read-file", 'F', Option::KEEP_STRING_OPTIONAL));
 	EMPLACE_BACK(Option, ("mask",      'm', Option::KEEP_STRING));
 }
 
+ATTRIBUTE_NONNULL_ static void strip_comment(string *line);
+static bool is_stdin(const string& name);
 ATTRIBUTE_NONNULL((1)) static void read_stdin(LineVec *lines, string *name);
 
 ATTRIBUTE_NONNULL((1)) static void add_file(LineVec *lines, const string& name, string *new_name);
@@ -90,19 +98,30 @@ inline static void add_file(LineVec *lines, const string& name) {
 
 ATTRIBUTE_NONNULL_ static void add_file(PreList *pre_list, const string& name);
 ATTRIBUTE_NONNULL_ static void add_words(LineVec *lines, const string& name);
-ATTRIBUTE_NONNULL_ static void read_args(MaskList<Mask> *mask_list, WordVec *args, const ArgumentReader& ar, const ParseError *parse_error);
+ATTRIBUTE_NONNULL_ static bool read_args(MaskList<Mask> *mask_list, WordVec *args, const ArgumentReader& ar, const ParseError *parse_error);
 ATTRIBUTE_NONNULL_ static const char *opt_arg(ArgumentReader::const_iterator *arg, const ArgumentReader& ar);
+static bool is_masked(const MaskList<Mask>& mask_list, const string& arg);
+static bool output_masked(const MaskList<Mask>& mask_list, const WordVec& args);
+static bool stream_stdin(const MaskList<Mask>& mask_list);
+
+static bool is_stdin(const string& name) {
+	return (name.empty() || (name == "-"));
+}
+
+static void strip_comment(string *line) {
+	string::size_type x(line->find('#'));
+	if(unlikely(x != string::npos)) {
+		line->erase(x);
+	}
+	trim(line);
+}
 
 static void read_stdin(LineVec *lines, string *name) {
 	static size_t stdin_count(0);
 	while(likely(!std::cin.eof())) {
 		string line;
 		getline(std::cin, line);
-		string::size_type x(line.find('#'));
-		if(unlikely(x != string::npos)) {
-			line.erase(x);
-		}
-		trim(&line);
+		strip_comment(&line);
 		lines->PUSH_BACK(MOVE(line));
 	}
 	if(stdin_count++ == 0) {
@@ -115,7 +134,7 @@ static void read_stdin(LineVec *lines, string *name) {
 }
 
 static void add_file(LineVec *lines, const string& name, string *new_name) {
-	if(name.empty() || (name == "-")) {
+	if(is_stdin(name)) {
 		read_stdin(lines, new_name);
 	} else {
 		pushback_lines(name.c_str(), lines, true);
@@ -149,11 +168,31 @@ static const char *opt_arg(ArgumentReader::const_iterator *arg, const ArgumentRe
 	return (*arg)->m_argument;
 }
 
-static void read_args(MaskList<Mask> *mask_list, WordVec *args, const ArgumentReader& ar, const ParseError *parse_error) {
+/**
+@return false if standard input is needed for other purposes than --stream
+**/
+static bool read_args(MaskList<Mask> *mask_list, WordVec *args, const ArgumentReader& ar, const ParseError *parse_error) {
 	PreList::LineNumber linenr(0);
 	PreList pre_list;
 	PreListEntry::FilenameIndex argindex(0);  // Dummy initialization
 	bool need_argindex(true);
+	for(ArgumentReader::const_iterator arg(ar.begin());
+		likely(arg != ar.end()); ++arg) {
+		switch(**arg) {
+			case 'f':
+			case 'F': {
+					char opt(**arg);
+					if(unlikely(rc_options.stream) && is_stdin(opt_arg(&arg, ar))) {
+						eix::say_error(_("%s: -%s cannot read standard input together with --stream"))
+							% program_name % opt;
+						return false;
+					}
+				}
+				break;
+			default:
+				break;
+		}
+	}
 	for(ArgumentReader::const_iterator arg(ar.begin());
 		likely(arg != ar.end()); ++arg) {
 		switch(**arg) {
@@ -176,6 +215,72 @@ static void read_args(MaskList<Mask> *mask_list, WordVec *args, const ArgumentRe
 		}
 	}
 	pre_list.initialize(mask_list, Mask::maskMask, parse_error);
+	return true;
+}
+
+/**
+@return true if arg matches some mask of mask_list
+**/
+static bool is_masked(const MaskList<Mask>& mask_list, const string& arg) {
+	Mask m(Mask::maskPseudomask);
+	string errtext;
+	if(unlikely(m.parseMask(arg.c_str(), &errtext) == BasicVersion::parsedError)) {
+		eix::say_error(_("warning: ignoring \"%s\": %s"))
+			% arg % errtext;
+		return false;
+	}
+	Package p;
+	m.to_package(&p);
+	if(!mask_list.applyMasks(&p)) {
+		return false;
+	}
+	for(Package::const_iterator v(p.begin()); v != p.end(); ++v) {
+		if(v->maskflags.isHardMasked()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+Output the args matching some mask of mask_list
+@return true if be_quiet is set and some arg matches
+**/
+static bool output_masked(const MaskList<Mask>& mask_list, const WordVec& args) {
+	for(WordVec::const_iterator it(args.begin());
+		likely(it != args.end()); ++it) {
+		if(is_masked(mask_list, *it)) {
+			if(rc_options.be_quiet) {
+				return true;
+			}
+			eix::say() % (*it);
+		}
+	}
+	return false;
+}
+
+/**
+Treat the words of standard input line by line as args,
+so that arbitrarily many args need not be kept in memory
+@return true if be_quiet is set and some arg matches
+**/
+static bool stream_stdin(const MaskList<Mask>& mask_list) {
+	string line;
+	WordVec words;
+	while(getline(std::cin, line)) {
+		strip_comment(&line);
+		if(line.empty()) {
+			continue;
+		}
+		words.clear();
+		split_string(&words, line);
+		if(output_masked(mask_list, words)) {
+			return true;
+		}
+		// A consumer might wait for our answer before sending more
+		std::fflush(stdout);
+	}
+	return false;
 }
 
 int run_masked_packages(int argc, char *argv[]) {
@@ -190,31 +295,13 @@ int run_masked_packages(int argc, char *argv[]) {
 	MaskList<Mask> mask_list;
 	WordVec args;
 	const ParseError *parse_error = new ParseError(rc_options.no_warn);
-	read_args(&mask_list, &args, argreader, parse_error);
+	if(unlikely(!read_args(&mask_list, &args, argreader, parse_error))) {
+		return EXIT_FAILURE;
+	}
 
-	for(WordVec::const_iterator it(args.begin());
-		likely(it != args.end()); ++it) {
-		Mask m(Mask::maskPseudomask);
-		string errtext;
-		if(unlikely(m.parseMask(it->c_str(), &errtext) == BasicVersion::parsedError)) {
-			eix::say_error(_("warning: ignoring \"%s\": %s"))
-				% (*it) % errtext;
-			continue;
-		}
-		Package p;
-		m.to_package(&p);
-		if(!mask_list.applyMasks(&p)) {
-			continue;
-		}
-		for(Package::const_iterator v(p.begin()); v != p.end(); ++v) {
-			if(v->maskflags.isHardMasked()) {
-				if(rc_options.be_quiet) {
-					return EXIT_SUCCESS;
-				}
-				eix::say() % (*it);
-				break;
-			}
-		}
+	if(output_masked(mask_list, args) ||
+		(rc_options.stream && stream_stdin(mask_list))) {
+		return EXIT_SUCCESS;
 	}
 	return (rc_options.be_quiet ? EXIT_FAILURE : EXIT_SUCCESS);
 }
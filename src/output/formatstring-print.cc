@@ -15,6 +15,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <utility>
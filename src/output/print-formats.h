@@ -10,6 +10,8 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <string>
+
 #include "eixTk/attribute.h"
 #include "portage/package.h"
 
@@ -18,6 +20,12 @@ class PrintFormats {
 		virtual void start() {}
 		virtual ATTRIBUTE_NONNULL_ void package(Package *) {}
 		virtual void finish() {}
+
+		/**
+		Enclose the packages of an expression in batch mode
+		**/
+		virtual void begin_query(const std::string& /* expression */) {}
+		virtual void end_query() {}
 		virtual ~PrintFormats() {}
 };
 
@@ -357,6 +357,12 @@ static void add_properties(eix_proto::Properties *properties, ExtendedVersion::R
 }
 
 void PrintProto::finish() {
+	if(batch != NULLPTR) {
+		batch->SerializeToOstream(&std::cout);
+		delete batch;
+		batch = NULLPTR;
+		return;
+	}
 	if(collection == NULLPTR) {
 		return;
 	}
@@ -365,10 +371,31 @@ void PrintProto::finish() {
 	collection = NULLPTR;
 }
 
+/**
+In batch mode, the collection belongs to the query of the batch.
+A collection from an earlier start() is ours and must be freed.
+**/
+void PrintProto::begin_query(const string& expression) {
+	if(batch == NULLPTR) {
+		delete collection;
+		batch = new eix_proto::Batch();
+	}
+	eix_proto::Query *query = batch->add_query();
+	query->set_expression(expression);
+	collection = query->mutable_collection();
+	category_index.clear();
+}
+
+void PrintProto::end_query() {
+	collection = NULLPTR;
+}
+
 #else
 
 void PrintProto::start() {}
 void PrintProto::finish() {}
+void PrintProto::begin_query(const std::string& /* expression */) {}
+void PrintProto::end_query() {}
 void PrintProto::package(Package *) {
 	eix::say_error(_("protobuf format is not compiled in"));
 	std::exit(EXIT_FAILURE);
@@ -25,6 +25,7 @@ class PrintFormat;
 class SetStability;
 
 namespace eix_proto {
+class Batch;
 class Collection;
 }
 
@@ -35,14 +36,15 @@ class PrintProto FINAL : public PrintFormats {
 		const PrintFormat *print_format;
 		const SetStability *stability;
 		eix_proto::Collection *collection;
+		eix_proto::Batch *batch;
 		typedef UNORDERED_MAP<std::string, int> CategoryIndex;
 		CategoryIndex category_index;
 
 	public:
 		ATTRIBUTE_NONNULL_ PrintProto(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability) :
-			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR) {}
+			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR), batch(NULLPTR) {}
 
-		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR) {}
+		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR), batch(NULLPTR) {}
 
 		void start() OVERRIDE;
 
@@ -50,6 +52,10 @@ class PrintProto FINAL : public PrintFormats {
 
 		void finish() OVERRIDE;
 
+		void begin_query(const std::string& expression) OVERRIDE;
+
+		void end_query() OVERRIDE;
+
 		~PrintProto() {
 			finish();
 		}
@@ -98,6 +98,20 @@ void PrintXml::finish() {
 	runclear();
 }
 
+void PrintXml::begin_query(const string& expression) {
+	start();
+	eix::say("\t<query expression=\"%s\">") % escape_xmlstring(true, expression);
+}
+
+void PrintXml::end_query() {
+	if(count) {
+		eix::say("\t</category>");
+	}
+	curcat.clear();
+	count = 0;
+	eix::say("\t</query>");
+}
+
 static void print_iuse(const IUseSet::IUseNaturalOrder& s, IUse::Flags wanted, const char *dflt) {
 	bool have_found(false);
 	for(IUseSet::IUseNaturalOrder::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
@@ -50,7 +50,7 @@ class PrintXml FINAL : public PrintFormats {
 
 	public:
 		typedef eix::UNumber XmlVersion;
-		static CONSTEXPR const XmlVersion current = 16;
+		static CONSTEXPR const XmlVersion current = 17;
 
 		ATTRIBUTE_NONNULL_ void init(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability, EixRc *eixrc, const std::string& port_dir) {
 			hdr = header;
@@ -72,6 +72,8 @@ class PrintXml FINAL : public PrintFormats {
 		void start() OVERRIDE;
 		ATTRIBUTE_NONNULL_ void package(Package *pkg) OVERRIDE;
 		void finish() OVERRIDE;
+		void begin_query(const std::string& expression) OVERRIDE;
+		void end_query() OVERRIDE;
 		static std::string escape_xmlstring(bool quoted, const std::string& s);
 		static void say_xml_element(const std::string& prefix, const std::string& name, const std::string& content);
 
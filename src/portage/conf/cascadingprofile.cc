@@ -41,6 +41,8 @@ using std::string;
 
 class ParseError;
 
+ATTRIBUTE_NONNULL_ static void read_profile_lines(LineVec *lines, const string& filename, bool keep_comments);
+
 /**
 Exclude this files from listing of files in profile
 **/
@@ -163,7 +165,44 @@ void CascadingProfile::init_static() {
 	profile_filenames = new ProfileFilenames;
 }
 
-bool CascadingProfile::readremoveFiles() {
+void CascadingProfile::prefetchFiles() const {
+	eix_assert_static(profile_filenames != NULLPTR);
+	for(ProfileFiles::const_iterator file(m_profile_files.begin());
+		likely(file != m_profile_files.end()); ++file) {
+		const char *filename(std::strrchr(file->c_str(), '/'));
+		if(filename == NULLPTR) {
+			continue;
+		}
+		++filename;
+		if(((*profile_filenames)[filename] == NULLPTR) &&
+			(std::strcmp(filename, "make.defaults") != 0)) {
+			continue;
+		}
+		if(!is_dir(file->c_str())) {
+			prefetch_file(file->c_str());
+			continue;
+		}
+		WordVec names;
+		pushback_files_recurse(file->name(), &names, true, NULLPTR);
+		for(WordVec::const_iterator it(names.begin());
+			likely(it != names.end()); ++it) {
+			prefetch_file(it->c_str());
+		}
+	}
+}
+
+/**
+Read the lines of a profile file as needed by its handler
+**/
+static void read_profile_lines(LineVec *lines, const string& filename, bool keep_comments) {
+	if(keep_comments) {
+		pushback_lines(filename.c_str(), lines, true, true, -1);
+	} else {
+		pushback_lines(filename.c_str(), lines, true);
+	}
+}
+
+bool CascadingProfile::readremoveFiles(FileCache *cache) {
 	eix_assert_static(profile_filenames != NULLPTR);
 	bool ret(false);
 	for(ProfileFiles::iterator file(m_profile_files.begin());
@@ -177,9 +216,23 @@ bool CascadingProfile::readremoveFiles() {
 		if(handler == NULLPTR) {
 			continue;
 		}
+		// Only the comments of package.mask are used
+		bool keep_comments(handler == &CascadingProfile::readPackageMasks);
+		LineVec uncached;
+		const LineVec *lines(&uncached);
+		if(cache == NULLPTR) {
+			read_profile_lines(&uncached, file->name(), keep_comments);
+		} else {
+			FileCache::size_type cached(cache->size());
+			LineVec& entry((*cache)[file->name()]);
+			if(cache->size() != cached) {
+				read_profile_lines(&entry, file->name(), keep_comments);
+			}
+			lines = &entry;
+		}
 		OverlayIdent& overlay(m_portagesettings->repos[file->repo_num()]);
 		overlay.readLabel();
-		if((this->*handler)(file->name(),
+		if((this->*handler)(file->name(), *lines,
 			(overlay.label.empty() ? NULLPTR : overlay.label.c_str()),
 			file->only_repo())) {
 			ret = true;
@@ -189,9 +242,7 @@ bool CascadingProfile::readremoveFiles() {
 	return ret;
 }
 
-bool CascadingProfile::readPackages(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+bool CascadingProfile::readPackages(const string& filename, const LineVec& lines, const char *repo, bool only_repo) {
 	bool ret(false);
 	PreList::FilenameIndex file_system(p_system.push_name(filename, repo, only_repo));
 	PreList::FilenameIndex file_profile(p_profile.push_name(filename, repo, only_repo));
@@ -227,27 +278,19 @@ bool CascadingProfile::readPackages(const string& filename, const char *repo, bo
 	return ret;
 }
 
-bool CascadingProfile::readPackageMasks(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true, true, -1);
+bool CascadingProfile::readPackageMasks(const string& filename, const LineVec& lines, const char *repo, bool only_repo) {
 	return p_package_masks.handle_file(lines, filename, repo, false, true, only_repo);
 }
 
-bool CascadingProfile::readPackageUnmasks(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+bool CascadingProfile::readPackageUnmasks(const string& filename, const LineVec& lines, const char *repo, bool only_repo) {
 	return p_package_unmasks.handle_file(lines, filename, repo, false, false, only_repo);
 }
 
-bool CascadingProfile::readPackageKeywords(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+bool CascadingProfile::readPackageKeywords(const string& filename, const LineVec& lines, const char *repo, bool only_repo) {
 	return p_package_keywords.handle_file(lines, filename, repo, false, false, only_repo);
 }
 
-bool CascadingProfile::readPackageAcceptKeywords(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+bool CascadingProfile::readPackageAcceptKeywords(const string& filename, const LineVec& lines, const char *repo, bool only_repo) {
 	return p_package_accept_keywords.handle_file(lines, filename, repo, true, false, only_repo);
 }
 
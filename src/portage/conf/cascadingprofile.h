@@ -19,6 +19,7 @@
 #include "eixTk/dialect.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
+#include "eixTk/unordered_map.h"
 #include "portage/mask.h"
 #include "portage/mask_list.h"
 #include "portage/overlay.h"
@@ -91,46 +92,53 @@ class CascadingProfile {
 		}
 
 		/**
-		Handler functions follow for reading a file
+		Handler functions follow for the lines of a file
 		**/
-		typedef bool (CascadingProfile::*Handler)(const std::string& filename, const char *repo, bool only_repo);
+		typedef bool (CascadingProfile::*Handler)(const std::string& filename, const LineVec& lines, const char *repo, bool only_repo);
 
 		/**
-		Read all "packages" files found in profile.
+		Handle all "packages" files found in profile.
 		Populate p_system and p_profile.
 		@return true if data was changed
 		**/
-		bool readPackages(const std::string& filename, const char *repo, bool only_repo);
+		bool readPackages(const std::string& filename, const LineVec& lines, const char *repo, bool only_repo);
 
 		/**
-		Read all "package.mask" files found in profile.
+		Handle all "package.mask" files found in profile.
 		Populate p_package_masks.
 		@return true if data was changed
 		**/
-		bool readPackageMasks(const std::string& filename, const char *repo, bool only_repo);
+		bool readPackageMasks(const std::string& filename, const LineVec& lines, const char *repo, bool only_repo);
 
 		/**
-		Read all "package.unmask" files found in profile.
+		Handle all "package.unmask" files found in profile.
 		Populate p_package_unmasks.
 		@return true if data was changed
 		**/
-		bool readPackageUnmasks(const std::string& filename, const char *repo, bool only_repo);
+		bool readPackageUnmasks(const std::string& filename, const LineVec& lines, const char *repo, bool only_repo);
 
 		/**
-		Read all "package.keywords" files found in profile.
+		Handle all "package.keywords" files found in profile.
 		Populate p_package_keywords.
 		@return true if data was changed
 		**/
-		bool readPackageKeywords(const std::string& filename, const char *repo, bool only_repo);
+		bool readPackageKeywords(const std::string& filename, const LineVec& lines, const char *repo, bool only_repo);
 
 		/**
-		Read all "package.accept_keywords" files found in profile.
+		Handle all "package.accept_keywords" files found in profile.
 		Populate p_package_accept_keywords.
 		@return true if data was changed
 		**/
-		bool readPackageAcceptKeywords(const std::string& filename, const char *repo, bool only_repo);
+		bool readPackageAcceptKeywords(const std::string& filename, const LineVec& lines, const char *repo, bool only_repo);
 
 	public:
+		/**
+		The lines of the files read for profiles, so that files which are
+		reached several times (e.g. the overlay files which are read for
+		the local and the non-local profile) are read only once
+		**/
+		typedef UNORDERED_MAP<std::string, LineVec> FileCache;
+
 		ATTRIBUTE_NONNULL_ CascadingProfile(PortageSettings *portagesettings, bool init_world) :
 			print_profile_paths(false),
 			use_world(false), finalized(false),
@@ -150,12 +158,22 @@ class CascadingProfile {
 		**/
 		void readMakeDefaults();
 
+		/**
+		Let the system fetch all files previously added by listadd...
+		in the background before they are read
+		**/
+		void prefetchFiles() const;
+
 		/**
 		Read all mask/system files previously added by listadd...
 		and clear this list of files afterwards.
+		@param cache if not NULLPTR, files are read only if not in cache
 		@return true if at least one file changed data.
 		**/
-		bool readremoveFiles();
+		bool readremoveFiles(FileCache *cache);
+		bool readremoveFiles() {
+			return readremoveFiles(NULLPTR);
+		}
 
 		/**
 		Cycle through profile and put path to files into m_profile_files
@@ -13,7 +13,6 @@
 #include <cstdlib>
 #include <cstring>
 
-#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -136,6 +135,57 @@ static CONSTEXPR const char *test_in_env_late[] = {
 	NULLPTR
 };
 
+void PortageSettings::append_environment(string *s) {
+	const char *const *lists[2] = { test_in_env_early, test_in_env_late };
+	for(int i(0); likely(i < 2); ++i) {
+		for(const char *const *var(lists[i]); likely(*var != NULLPTR); ++var) {
+			const char *value(std::getenv(*var));
+			if(value != NULLPTR) {
+				s->append(*var);
+				s->append(1, '=');
+				s->append(value);
+			}
+			s->append(1, '\0');
+		}
+	}
+}
+
+void PortageSettings::append_stability_settings(string *s) const {
+	static CONSTEXPR const char *rc_vars[] = {
+		"DEFAULT_ARCH",
+		"EPREFIX",
+		"EPREFIX_SOURCE",
+		"EPREFIX_PORTAGE_PROFILE",
+		"EPREFIX_PORTDIR",
+		"EPREFIX_OVERLAYS",
+		"EPREFIX_ACCESS_OVERLAYS",
+		"RECURSIVE_SETS",
+		"CURRENT_WORLD",
+		"EIX_WORLD",
+		"EIX_WORLD_SETS",
+		"EIX_LOCAL_SETS",
+		"ACCEPT_KEYWORDS_AS_ARCH",
+		NULLPTR
+	};
+	s->append(m_eprefixconf);
+	s->append(1, '\0');
+	for(const char *const *var(rc_vars); likely(*var != NULLPTR); ++var) {
+		s->append(*var);
+		s->append(1, '=');
+		s->append((*settings_rc)[*var]);
+		s->append(1, '\0');
+	}
+	append_environment(s);
+	string keywords;
+	join_to_string(&keywords, m_accepted_keywords_set);
+	s->append(keywords);
+	s->append(1, '\0');
+	join_to_string(&keywords, *m_local_arch_set);
+	s->append(keywords);
+	s->append(1, '\0');
+	s->append(m_raised_arch);
+}
+
 void PortageSettings::override_by_map(const char *const *vars, const WordIterateMap& varmap) {
 	for(const char *var(*vars); likely(var != NULLPTR); var = *(++vars)) {
 		WordIterateMap::const_iterator it(varmap.find(var));
@@ -395,8 +445,10 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 	if(unlikely(print_profile_paths)) {
 		return;
 	}
+	CascadingProfile::FileCache file_cache;
+	profile->prefetchFiles();
 	profile->readMakeDefaults();
-	profile->readremoveFiles();
+	profile->readremoveFiles(&file_cache);
 	CascadingProfile *local_profile(NULLPTR);
 	if(getlocal) {
 		local_profile = new CascadingProfile(*profile);
@@ -405,16 +457,18 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 	if(getlocal) {
 		local_profile->listaddProfile((m_eprefixconf + USER_PROFILE_DIR).c_str());
 		addOverlayProfiles(local_profile);
+		local_profile->prefetchFiles();
 		local_profile->readMakeDefaults();
-		if(!local_profile->readremoveFiles()) {
+		if(!local_profile->readremoveFiles(&file_cache)) {
 			// local_profile does not differ; we do not need it
 			delete local_profile;
 			local_profile = NULLPTR;
 		}
 	} else {
+		profile->prefetchFiles();
 		profile->readMakeDefaults();
 	}
-	profile->readremoveFiles();
+	profile->readremoveFiles(&file_cache);
 	read_make_conf_late(eprefixsource);
 	override_by_env(test_in_env_late);
 
@@ -445,7 +499,9 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 		}
 	} else {
 		m_local_arch_set = m_auto_arch_set = &m_arch_set;
-	} {
+	}
+	m_accepted_memo.init(&m_accepted_keywords_set);
+	m_auto_arch_memo.init(m_auto_arch_set); {
 		// Calculate m_raised_arch by prepending ~ to every token
 		WordSet archset;
 		for(WordSet::const_iterator it(m_arch_set.begin());
@@ -588,15 +644,7 @@ void PortageSettings::calc_world_sets(Package *p) {
 				continue;
 			}
 		}
-		bool world(false);
-		for(Version::SetsIndizes::const_iterator sit(it->sets_indizes.begin());
-			sit != it->sets_indizes.end(); ++sit) {
-			if(std::find(world_setslist.begin(), world_setslist.end(), *sit) != world_setslist.end()) {
-				world = true;
-				break;
-			}
-		}
-		if(world) {
+		if(it->sets_bits.intersects(world_setslist.bits())) {
 			it->maskflags.setbits(MaskFlags::MASK_WORLD_SETS);
 		}
 	}
@@ -604,10 +652,15 @@ void PortageSettings::calc_world_sets(Package *p) {
 
 void PortageSettings::get_setnames(WordSet *names, const Package *p, bool also_nonlocal) const {
 	names->clear();
+	SetsBits bits;
 	for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it) {
-		for(Version::SetsIndizes::const_iterator sit(it->sets_indizes.begin());
-			likely(sit != it->sets_indizes.end()); ++sit) {
-			names->INSERT(set_names[*sit]);
+		bits.add(it->sets_bits);
+	}
+	if(!bits.empty()) {
+		for(SetsIndex i(0); likely(i != set_names.size()); ++i) {
+			if(bits.has(i)) {
+				names->INSERT(set_names[i]);
+			}
 		}
 	}
 	if(also_nonlocal) {
@@ -701,6 +754,9 @@ void PortageSettings::read_local_sets(const WordVec& dir_list) {
 
 void PortageSettings::calc_recursive_sets(Package *p) const {
 	for(Package::iterator vi(p->begin()); likely(vi != p->end()); ++vi) {
+		if(likely(vi->sets_indizes.empty())) {
+			continue;
+		}
 		SetsList will_add;
 		for(Version::SetsIndizes::const_iterator it(vi->sets_indizes.begin());
 			it != vi->sets_indizes.end(); ++it)
@@ -1128,7 +1184,7 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 		}
 		if(kv.size() == kvsize) {
 			// Nothing has changed. In this case, we take defaults:
-			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_set));
+			kf.set_keyflags(it->get_keyflags(&(m_settings->m_accepted_memo)));
 			it->keyflags = kf;
 			it->save_keyflags(Version::SAVEKEY_ACCEPT);
 		} else {
@@ -1309,20 +1365,20 @@ void PortageUserConfig::pushback_set_accepted_keywords(WordVec *result, const Ve
 Set stability according to arch or local ACCEPT_KEYWORDS
 **/
 void PortageSettings::setKeyflags(Package *p, bool use_accepted_keywords) const {
-	const WordSet *accept_set;
+	KeyflagsMemo *memo;
 	Version::SavedKeyIndex ind;
 	if(use_accepted_keywords) {
 		ind = Version::SAVEKEY_ACCEPT;
-		accept_set = &m_accepted_keywords_set;
+		memo = &m_accepted_memo;
 	} else {
 		ind = Version::SAVEKEY_ARCH;
-		accept_set = m_auto_arch_set;
+		memo = &m_auto_arch_memo;
 	}
 	if(p->restore_keyflags(ind))
 		return;
 	get_effective_keywords_profile(p);
 	for(Package::iterator t(p->begin()); likely(t != p->end()); ++t) {
-		t->set_keyflags(*accept_set);
+		t->set_keyflags(memo);
 		t->save_keyflags(ind);
 	}
 }
@@ -171,6 +171,10 @@ class PortageSettings : public WordIterateMap {
 		WordSet                  m_accepted_keywords_set, m_arch_set,
 		                         m_plain_accepted_keywords_set,
 		                        *m_local_arch_set, *m_auto_arch_set;
+		/**
+		The keyflags for m_accepted_keywords_set and *m_auto_arch_set
+		**/
+		mutable KeyflagsMemo     m_accepted_memo, m_auto_arch_memo;
 		std::string              m_raised_arch;
 
 		MaskList<SetMask>        m_package_sets;
@@ -338,6 +342,17 @@ class PortageSettings : public WordIterateMap {
 
 		ATTRIBUTE_NONNULL_ bool use_expand(std::string *var, std::string *expvar, const std::string& value) const;
 
+		/**
+		Append the environment variables which influence the settings to *s
+		**/
+		ATTRIBUTE_NONNULL_ static void append_environment(std::string *s);
+
+		/**
+		Append all settings besides the content of files which influence
+		the local mask and keyword flags to *s
+		**/
+		ATTRIBUTE_NONNULL_ void append_stability_settings(std::string *s) const;
+
 		static void init_static();
 };
 
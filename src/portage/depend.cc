@@ -8,78 +8,239 @@
 #include "portage/depend.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <cstring>
+
+#include <algorithm>
+#include <deque>
 #include <string>
 
+#include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
 bool Depend::use_depend;
 
+const Depend::Kind
+	Depend::KIND_WORD,
+	Depend::KIND_ATOM,
+	Depend::KIND_BLOCKER,
+	Depend::KIND_USE,
+	Depend::KIND_GROUP,
+	Depend::KIND_OPEN,
+	Depend::KIND_CLOSE,
+	Depend::KIND_SAME;
+
+const Depend::Classes
+	Depend::CLASS_NONE,
+	Depend::CLASS_DEPEND,
+	Depend::CLASS_RDEPEND,
+	Depend::CLASS_PDEPEND,
+	Depend::CLASS_BDEPEND,
+	Depend::CLASS_IDEPEND,
+	Depend::CLASS_ALL;
+
 const char Depend::c_depend[] = "${DEPEND}";
 const char Depend::c_rdepend[] = "${RDEPEND}";
 
 static CONSTEXPR const char the_same = '"';
 
-static bool subst_the_same(string *in, const string& from);
+/**
+An entry of the dictionary of dependency words
+**/
+class DependWord {
+	public:
+		string word, atom;
+		Depend::Kind kind;
 
-static bool subst_the_same(string *in, const string& from) {
-	if(from.empty()) {
-		return false;
+		explicit DependWord(const string& w);
+};
+
+/**
+A deque, since references to its entries must stay valid
+**/
+typedef std::deque<DependWord> Dictionary;
+typedef UNORDERED_MAP<string, Depend::Token> DictionaryIndex;
+
+static Dictionary dictionary;
+static DictionaryIndex dictionary_index;
+
+ATTRIBUTE_NONNULL_ static bool atom_name(string *name, const char *s);
+ATTRIBUTE_NONNULL_ static bool subst_the_same(Depend::Tokens *in, const Depend::Tokens& from);
+static string subst_obsolete(const string& in, const string& text);
+
+/**
+Set *name to category/name of the atom s.
+@return false if s is no atom
+**/
+static bool atom_name(string *name, const char *s) {
+	bool versioned(false);
+	for(; (*s == '<') || (*s == '>') || (*s == '=') || (*s == '~'); ++s) {
+		versioned = true;
 	}
-	string::size_type pos(in->find(from));
-	if(pos == string::npos) {
+	const char *end(NULLPTR);
+	if(versioned) {
+		end = ExplodeAtom::get_start_of_version(s, true);
+		if(likely(end != NULLPTR)) {
+			--end;  // the '-' before the version
+		}
+	}
+	if(end == NULLPTR) {
+		end = s + std::strcspn(s, ":[");
+	}
+	const char *slash(std::strchr(s, '/'));
+	if(unlikely((slash == NULLPTR) || (slash == s) || (slash + 1 >= end))) {
 		return false;
 	}
-	string::size_type len(from.size());
-	string::size_type next(pos + len);
-	if(next < in->size()) {
-		if((*in)[next] != ' ') {
-			return false;
+GCC_DIAG_OFF(sign-conversion)
+	name->assign(s, end - s);
+GCC_DIAG_ON(sign-conversion)
+	return true;
+}
+
+DependWord::DependWord(const string& w) : word(w), kind(Depend::KIND_WORD) {
+	const char *s(w.c_str());
+	if(unlikely(w.empty())) {
+		return;
+	}
+	if((w.size() == 1) && (*s == the_same)) {
+		kind = Depend::KIND_SAME;
+	} else if((w.size() == 1) && (*s == '(')) {
+		kind = Depend::KIND_OPEN;
+	} else if((w.size() == 1) && (*s == ')')) {
+		kind = Depend::KIND_CLOSE;
+	} else if((w == "||") || (w == "^^") || (w == "??")) {
+		kind = Depend::KIND_GROUP;
+	} else if(w[w.size() - 1] == '?') {
+		kind = Depend::KIND_USE;
+	} else if((*s == '(') || (*s == ')')) {
+		return;
+	} else if(*s == '!') {
+		s += ((s[1] == '!') ? 2 : 1);
+		if(atom_name(&atom, s)) {
+			kind = Depend::KIND_BLOCKER;
 		}
+	} else if(atom_name(&atom, s)) {
+		kind = Depend::KIND_ATOM;
 	}
-	if(pos > 0) {
-		if((*in)[pos - 1] != ' ') {
-			return false;
+}
+
+Depend::Token Depend::intern(const string& w) {
+	DictionaryIndex::const_iterator it(dictionary_index.find(w));
+	if(likely(it != dictionary_index.end())) {
+		return it->second;
+	}
+	Token t(dictionary.size());
+	dictionary.PUSH_BACK(DependWord(w));
+	dictionary_index[w] = t;
+	return t;
+}
+
+const string& Depend::word(Token t) {
+	return dictionary[t].word;
+}
+
+Depend::Kind Depend::kind(Token t) {
+	return dictionary[t].kind;
+}
+
+const string& Depend::atom(Token t) {
+	return dictionary[t].atom;
+}
+
+void Depend::tokenize(Tokens *tokens, const string& s) {
+	WordVec words;
+	split_string(&words, s);
+	tokens->clear();
+	tokens->reserve(words.size());
+	for(WordVec::const_iterator it(words.begin()); likely(it != words.end()); ++it) {
+		tokens->PUSH_BACK(intern(*it));
+	}
+}
+
+string Depend::join(const Tokens& tokens, const Tokens& same, const char *brief) {
+	string ret;
+	for(Tokens::const_iterator it(tokens.begin()); likely(it != tokens.end()); ++it) {
+		const DependWord& w(dictionary[*it]);
+		if(likely(w.kind != KIND_SAME) || unlikely(&tokens == &same)) {
+			if(!ret.empty()) {
+				ret.append(1, ' ');
+			}
+			ret.append(w.word);
+			continue;
+		}
+		if(brief != NULLPTR) {
+			if(!ret.empty()) {
+				ret.append(1, ' ');
+			}
+			ret.append(brief);
+			continue;
+		}
+		for(Tokens::const_iterator s(same.begin()); likely(s != same.end()); ++s) {
+			if(!ret.empty()) {
+				ret.append(1, ' ');
+			}
+			ret.append(dictionary[*s].word);
 		}
 	}
-	in->erase(pos, len - 1);
-	(*in)[pos] = the_same;
-	return true;
+	return ret;
+}
+
+const string& Depend::joined(JoinedIndex i, const Tokens& tokens, const Tokens& same, const char *brief) const {
+	if(m_joined.empty()) {
+		m_joined.resize(JOINED_SIZE);
+	}
+	string& ret(m_joined[i]);
+	if(ret.empty() && !tokens.empty()) {
+		ret = join(tokens, same, brief);
+	}
+	return ret;
 }
 
-void Depend::set(const string& depend, const string& rdepend, const string& pdepend, const string& bdepend, const string& idepend, bool normspace) {
-	m_depend = depend;
-	m_rdepend = rdepend;
-	m_pdepend = pdepend;
-	m_bdepend = bdepend;
-	m_idepend = idepend;
-	if(normspace) {
-		trimall(&m_depend);
-		trimall(&m_rdepend);
-		trimall(&m_pdepend);
-		trimall(&m_bdepend);
-		trimall(&m_idepend);
+/**
+Replace the first occurrence of the tokens from in *in by KIND_SAME
+**/
+static bool subst_the_same(Depend::Tokens *in, const Depend::Tokens& from) {
+	if(from.empty()) {
+		return false;
 	}
+	Depend::Tokens::iterator pos(std::search(in->begin(), in->end(), from.begin(), from.end()));
+	if(pos == in->end()) {
+		return false;
+	}
+	*pos = Depend::intern(string(1, the_same));
+	in->erase(pos + 1, pos + from.size());
+	return true;
+}
+
+void Depend::set(const string& depend, const string& rdepend, const string& pdepend, const string& bdepend, const string& idepend) {
+	m_joined.clear();
+	tokenize(&m_depend, depend);
+	tokenize(&m_rdepend, rdepend);
+	tokenize(&m_pdepend, pdepend);
+	tokenize(&m_bdepend, bdepend);
+	tokenize(&m_idepend, idepend);
 	subst_the_same(&m_depend, m_rdepend) || \
 		subst_the_same(&m_rdepend, m_depend);
-	obsolete = false;
 }
 
-string Depend::subst(const string& in, const string& text, bool obs) {
+static string subst_obsolete(const string& in, const string& text) {
 	string::size_type pos(in.find(the_same));
 	if(pos == string::npos) {
 		return in;
 	}
 	string ret(in);
-	if(unlikely(obs) && ((pos + 1) != ret.size())) {
+	if((pos + 1) != ret.size()) {
 		ret[pos] = ' ';
 		if(pos > 0) {
 			ret.insert(++pos, 1, ' ');
 		}
-	} else if(unlikely(obs) && (pos > 0)) {
+	} else if(pos > 0) {
 		ret[pos++] = ' ';
 	} else {
 		ret.erase(pos, 1);
@@ -88,10 +249,112 @@ string Depend::subst(const string& in, const string& text, bool obs) {
 	return ret;
 }
 
+void Depend::normalize_obsolete() {
+	string quote(1, the_same);
+	string depend(join(m_depend, m_depend, quote.c_str()));
+	string rdepend(join(m_rdepend, m_rdepend, quote.c_str()));
+	m_joined.clear();
+	tokenize(&m_depend, subst_obsolete(depend, rdepend));
+	tokenize(&m_rdepend, subst_obsolete(rdepend, depend));
+	subst_the_same(&m_depend, m_rdepend) || \
+		subst_the_same(&m_rdepend, m_depend);
+}
+
+void Depend::add_atoms(Atoms *atoms, const Tokens& tokens, const Tokens& same, Classes c) {
+	for(Tokens::const_iterator it(tokens.begin()); likely(it != tokens.end()); ++it) {
+		const DependWord& w(dictionary[*it]);
+		if(w.kind == KIND_ATOM) {
+			(*atoms)[w.atom] |= c;
+		} else if(unlikely(w.kind == KIND_SAME) && likely(&tokens != &same)) {
+			add_atoms(atoms, same, same, c);
+		}
+	}
+}
+
+void Depend::add_atoms(Atoms *atoms, const string& s, Classes c) {
+	Tokens tokens;
+	tokenize(&tokens, s);
+	add_atoms(atoms, tokens, tokens, c);
+}
+
+void Depend::get_atoms(Atoms *atoms) const {
+	add_atoms(atoms, m_depend, m_rdepend, CLASS_DEPEND);
+	add_atoms(atoms, m_rdepend, m_depend, CLASS_RDEPEND);
+	add_atoms(atoms, m_pdepend, m_pdepend, CLASS_PDEPEND);
+	add_atoms(atoms, m_bdepend, m_bdepend, CLASS_BDEPEND);
+	add_atoms(atoms, m_idepend, m_idepend, CLASS_IDEPEND);
+}
+
+bool Depend::has_atom(const Tokens& tokens, const Tokens& same, const string& atom) {
+	for(Tokens::const_iterator it(tokens.begin()); likely(it != tokens.end()); ++it) {
+		const DependWord& w(dictionary[*it]);
+		if(w.kind == KIND_ATOM) {
+			if(w.atom == atom) {
+				return true;
+			}
+		} else if(unlikely(w.kind == KIND_SAME) && likely(&tokens != &same)) {
+			if(has_atom(same, same, atom)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+Depend::Classes Depend::atom_classes(const string& atom) const {
+	Classes c(CLASS_NONE);
+	if(has_atom(m_depend, m_rdepend, atom)) {
+		c |= CLASS_DEPEND;
+	}
+	if(has_atom(m_rdepend, m_depend, atom)) {
+		c |= CLASS_RDEPEND;
+	}
+	if(has_atom(m_pdepend, m_pdepend, atom)) {
+		c |= CLASS_PDEPEND;
+	}
+	if(has_atom(m_bdepend, m_bdepend, atom)) {
+		c |= CLASS_BDEPEND;
+	}
+	if(has_atom(m_idepend, m_idepend, atom)) {
+		c |= CLASS_IDEPEND;
+	}
+	return c;
+}
+
+bool Depend::parse_classes(Classes *c, const string& s) {
+	*c = CLASS_NONE;
+	WordVec words;
+	split_string(&words, s, false, ", ");
+	for(WordVec::const_iterator it(words.begin()); likely(it != words.end()); ++it) {
+		if(*it == "depend") {
+			*c |= CLASS_DEPEND;
+		} else if(*it == "rdepend") {
+			*c |= CLASS_RDEPEND;
+		} else if(*it == "pdepend") {
+			*c |= CLASS_PDEPEND;
+		} else if(*it == "bdepend") {
+			*c |= CLASS_BDEPEND;
+		} else if(*it == "idepend") {
+			*c |= CLASS_IDEPEND;
+		} else {
+			return false;
+		}
+	}
+	return (*c != CLASS_NONE);
+}
+
 bool Depend::operator==(const Depend& d) const {
-	return ((get_depend() == d.get_depend()) &&
-		(get_rdepend() == d.get_rdepend()) &&
-		(get_pdepend() == d.get_pdepend()) &&
-		(get_bdepend() == d.get_bdepend()) &&
-		(get_idepend() == d.get_idepend()));
+	if((m_depend == d.m_depend) &&
+		(m_rdepend == d.m_rdepend) &&
+		(m_pdepend == d.m_pdepend) &&
+		(m_bdepend == d.m_bdepend) &&
+		(m_idepend == d.m_idepend)) {
+		return true;
+	}
+	// The placeholder might be used differently
+	return ((m_pdepend == d.m_pdepend) &&
+		(m_bdepend == d.m_bdepend) &&
+		(m_idepend == d.m_idepend) &&
+		(get_depend() == d.get_depend()) &&
+		(get_rdepend() == d.get_rdepend()));
 }
@@ -10,70 +10,142 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <map>
 #include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/null.h"
 
 class Database;
 class DBHeader;
 class Version;
 class PackageTree;
 
+/**
+The dependency strings of a version.
+Each string is kept as a sequence of tokens: A token is the index of a word
+in a dictionary shared by all dependency strings. The kind of a word
+(atom, blocker, USE conditional, ...) and the category/name of an atom
+are determined only once per word; strings are built only on request.
+**/
 class Depend {
 	friend class Database;
 
-	private:
-		std::string m_depend, m_rdepend, m_pdepend, m_bdepend, m_idepend;
-		bool obsolete;
+	public:
+		typedef uint32_t Token;
+		typedef std::vector<Token> Tokens;
+
+		typedef uint8_t Kind;
+		static CONSTEXPR const Kind
+			KIND_WORD    = 0,  ///< anything else
+			KIND_ATOM    = 1,
+			KIND_BLOCKER = 2,
+			KIND_USE     = 3,  ///< USE conditional like flag? or !flag?
+			KIND_GROUP   = 4,  ///< ||, ^^, or ??
+			KIND_OPEN    = 5,
+			KIND_CLOSE   = 6,
+			KIND_SAME    = 7;  ///< stands for the tokens of RDEPEND or DEPEND
+
+		typedef uint8_t Classes;
+		static CONSTEXPR const Classes
+			CLASS_NONE    = 0x00U,
+			CLASS_DEPEND  = 0x01U,
+			CLASS_RDEPEND = 0x02U,
+			CLASS_PDEPEND = 0x04U,
+			CLASS_BDEPEND = 0x08U,
+			CLASS_IDEPEND = 0x10U,
+			CLASS_ALL     = 0x1FU;
+
+		/**
+		Map category/name of an atom to the classes of dependencies
+		**/
+		typedef std::map<std::string, Classes> Atoms;
 
-		static const char c_depend[];
-		static const char c_rdepend[];
+		static bool use_depend;
 
-		static std::string subst(const std::string& in, const std::string& text, bool obs);
+		/**
+		@return the token of word, adding it to the dictionary if necessary
+		**/
+		static Token intern(const std::string& word);
 
-	public:
-		static bool use_depend;
+		ATTRIBUTE_PURE static const std::string& word(Token t);
+
+		ATTRIBUTE_PURE static Kind kind(Token t);
+
+		/**
+		@return category/name of an atom or blocker token, empty otherwise
+		**/
+		ATTRIBUTE_PURE static const std::string& atom(Token t);
 
-		Depend() : obsolete(false) {
+		/**
+		Set the dependency strings; whitespace is normalized
+		**/
+		void set(const std::string& depend, const std::string& rdepend, const std::string& pdepend, const std::string& bdepend, const std::string& idepend);
+
+		const std::string& get_depend() const {
+			return joined(JOINED_DEPEND, m_depend, m_rdepend, NULLPTR);
 		}
 
-		void set(const std::string& depend, const std::string& rdepend, const std::string& pdepend, const std::string& bdepend, const std::string& idepend, bool normspace);
+		const std::string& get_depend_brief() const {
+			return joined(JOINED_DEPEND_BRIEF, m_depend, m_rdepend, c_rdepend);
+		}
 
-		std::string get_depend() const {
-			return subst(m_depend, m_rdepend, obsolete);
+		const std::string& get_rdepend() const {
+			return joined(JOINED_RDEPEND, m_rdepend, m_depend, NULLPTR);
 		}
 
-		std::string get_depend_brief() const {
-			return subst(m_depend, c_rdepend, obsolete);
+		const std::string& get_rdepend_brief() const {
+			return joined(JOINED_RDEPEND_BRIEF, m_rdepend, m_depend, c_depend);
 		}
 
-		std::string get_rdepend() const {
-			return subst(m_rdepend, m_depend, obsolete);
+		const std::string& get_pdepend() const {
+			return joined(JOINED_PDEPEND, m_pdepend, m_pdepend, NULLPTR);
 		}
 
-		std::string get_rdepend_brief() const {
-			return subst(m_rdepend, c_depend, obsolete);
+		const std::string& get_pdepend_brief() const {
+			return get_pdepend();
 		}
 
-		std::string get_pdepend() const {
-			return m_pdepend;
+		const std::string& get_bdepend() const {
+			return joined(JOINED_BDEPEND, m_bdepend, m_bdepend, NULLPTR);
 		}
 
-		std::string get_pdepend_brief() const {
-			return m_pdepend;
+		const std::string& get_bdepend_brief() const {
+			return get_bdepend();
 		}
 
-		std::string get_bdepend() const {
-			return m_bdepend;
+		const std::string& get_idepend() const {
+			return joined(JOINED_IDEPEND, m_idepend, m_idepend, NULLPTR);
 		}
 
-		std::string get_bdepend_brief() const {
-			return m_bdepend;
+		const std::string& get_idepend_brief() const {
+			return get_idepend();
 		}
 
-		std::string get_idepend() const {
-			return m_idepend;
+		/**
+		The tokens of the dependency strings; a token of KIND_SAME in
+		depend_tokens() stands for rdepend_tokens() and vice versa
+		**/
+		const Tokens& depend_tokens() const {
+			return m_depend;
+		}
+
+		const Tokens& rdepend_tokens() const {
+			return m_rdepend;
 		}
 
-		std::string get_idepend_brief() const {
+		const Tokens& pdepend_tokens() const {
+			return m_pdepend;
+		}
+
+		const Tokens& bdepend_tokens() const {
+			return m_bdepend;
+		}
+
+		const Tokens& idepend_tokens() const {
 			return m_idepend;
 		}
 
@@ -102,19 +174,87 @@ class Depend {
 		}
 
 		void clear() {
+			m_joined.clear();
 			m_depend.clear();
 			m_rdepend.clear();
 			m_pdepend.clear();
 			m_bdepend.clear();
 			m_idepend.clear();
-			obsolete = false;
 		}
 
+		/**
+		Add the category/name of all atoms of dependencies to *atoms.
+		Blockers are ignored.
+		**/
+		ATTRIBUTE_NONNULL_ void get_atoms(Atoms *atoms) const;
+
+		/**
+		Add the category/name of all atoms of the dependency string s
+		with class c to *atoms. Blockers are ignored.
+		**/
+		ATTRIBUTE_NONNULL_ static void add_atoms(Atoms *atoms, const std::string& s, Classes c);
+
+		/**
+		@return the classes of the dependencies with an atom of category/name.
+		Blockers are ignored.
+		**/
+		Classes atom_classes(const std::string& atom) const;
+
+		/**
+		Set *c to the classes named in s, a comma or space separated list
+		of depend, rdepend, pdepend, bdepend, idepend.
+		@return false if s contains some other word or no class
+		**/
+		ATTRIBUTE_NONNULL_ static bool parse_classes(Classes *c, const std::string& s);
+
 		bool operator==(const Depend& d) const;
 
 		bool operator!=(const Depend& d) const {
 			return !(*this == d);
 		}
+
+	private:
+		Tokens m_depend, m_rdepend, m_pdepend, m_bdepend, m_idepend;
+
+		typedef enum {
+			JOINED_DEPEND, JOINED_DEPEND_BRIEF,
+			JOINED_RDEPEND, JOINED_RDEPEND_BRIEF,
+			JOINED_PDEPEND, JOINED_BDEPEND, JOINED_IDEPEND,
+			JOINED_SIZE
+		} JoinedIndex;
+
+		/**
+		The strings built from the tokens, each only on its first request.
+		An empty entry is not yet built unless its tokens are empty.
+		This is empty as long as no string was requested.
+		**/
+		mutable std::vector<std::string> m_joined;
+
+		static const char c_depend[];
+		static const char c_rdepend[];
+
+		ATTRIBUTE_NONNULL_ static void tokenize(Tokens *tokens, const std::string& s);
+
+		/**
+		@return the string of tokens with KIND_SAME replaced by same
+		or by brief (if not NULLPTR)
+		**/
+		static std::string join(const Tokens& tokens, const Tokens& same, const char *brief);
+
+		/**
+		@return the cached result of join(tokens, same, brief)
+		**/
+		const std::string& joined(JoinedIndex i, const Tokens& tokens, const Tokens& same, const char *brief) const;
+
+		ATTRIBUTE_NONNULL_ static void add_atoms(Atoms *atoms, const Tokens& tokens, const Tokens& same, Classes c);
+
+		static bool has_atom(const Tokens& tokens, const Tokens& same, const std::string& atom);
+
+		/**
+		Databases up to format 32 may contain the placeholder for the
+		same dependencies within words; split it off
+		**/
+		void normalize_obsolete();
 };
 
 
@@ -14,6 +14,8 @@
 
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
+#include "eixTk/sharedstring.h"
+#include "eixTk/stringutils.h"
 #include "portage/basicversion.h"
 #include "portage/package.h"
 
@@ -50,8 +52,15 @@ const ExtendedVersion::HaveBinPkg
 
 bool ExtendedVersion::use_src_uri;
 
+void ExtendedVersion::set_slotname(const string& str) {
+	string slot, subslot;
+	slot_subslot(str, &slot, &subslot);
+	slotname = slot;
+	subslotname = subslot;
+}
+
 string ExtendedVersion::get_longfullslot() const {
-	return (subslotname.empty() ? (slotname.empty() ? "0" : slotname) :
+	return (subslotname.empty() ? (slotname.empty() ? string("0") : slotname.str()) :
 		(slotname.empty() ? (string("0/") + subslotname) : (slotname + "/" + subslotname)));
 }
 
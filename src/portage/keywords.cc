@@ -17,6 +17,7 @@
 #include "eixTk/likely.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
@@ -123,6 +124,16 @@ KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywo
 	return m;
 }
 
+KeywordsFlags::KeyType KeyflagsMemo::get_keyflags(const string& keywords) {
+	Memo::const_iterator it(m_memo.find(keywords));
+	if(likely(it != m_memo.end())) {
+		return it->second;
+	}
+	KeywordsFlags::KeyType t(KeywordsFlags::get_keyflags(*m_accepted_keywords, keywords));
+	m_memo[keywords] = t;
+	return t;
+}
+
 const Keywords::Redundant
 	Keywords::RED_NOTHING,
 	Keywords::RED_DOUBLE,
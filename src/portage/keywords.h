@@ -19,6 +19,7 @@
 #include "eixTk/inttypes.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
+#include "eixTk/unordered_map.h"
 
 class MaskFlags {
 	public:
@@ -269,6 +270,33 @@ inline static bool operator!=(const KeywordsFlags& left, const KeywordsFlags& ri
 	return (left.get() != right.get());
 }
 
+/**
+The keyflags of KEYWORDS strings for a fixed set of accepted keywords.
+Most versions share one of a few distinct KEYWORDS strings, so the
+keyflags are calculated only once for each of these strings.
+**/
+class KeyflagsMemo {
+	public:
+		KeyflagsMemo() : m_accepted_keywords(NULLPTR) {
+		}
+
+		/**
+		Must be called before get_keyflags() and whenever
+		*accepted_keywords is changed
+		**/
+		void init(const WordSet *accepted_keywords) {
+			m_accepted_keywords = accepted_keywords;
+			m_memo.clear();
+		}
+
+		KeywordsFlags::KeyType get_keyflags(const std::string& keywords);
+
+	private:
+		typedef UNORDERED_MAP<std::string, KeywordsFlags::KeyType> Memo;
+		const WordSet *m_accepted_keywords;
+		Memo m_memo;
+};
+
 class Keywords {
 	public:
 		typedef uint32_t Redundant;
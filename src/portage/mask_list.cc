@@ -252,13 +252,26 @@ bool PreList::remove_line(const std::string& line) {
 	return remove_splitted(l);
 }
 
+/**
+The words are joined by newlines which cannot occur in a line
+**/
+void PreList::have_key(string *key, const LineVec& line) {
+	key->clear();
+	for(LineVec::const_iterator it(line.begin()); likely(it != line.end()); ++it) {
+		key->append(*it);
+		key->append(1, '\n');
+	}
+}
+
 bool PreList::add_splitted(const LineVec& line, FilenameIndex file, LineNumber number) {
 	if(line.empty()) {
 		return false;
 	}
-	Have::iterator it(have.find(line));
+	string key;
+	have_key(&key, line);
+	Have::iterator it(have.find(key));
 	if(it == have.end()) {
-		have[line] = order.size();
+		have[key] = order.size();
 		order.EMPLACE_BACK(PreListOrderEntry, (line, file, number));
 		return true;
 	}
@@ -278,7 +291,9 @@ bool PreList::remove_splitted(const LineVec& line) {
 	if(line.empty()) {
 		return false;
 	}
-	Have::iterator it(have.find(line));
+	string key;
+	have_key(&key, line);
+	Have::iterator it(have.find(key));
 	if(it == have.end()) {
 		return false;
 	}
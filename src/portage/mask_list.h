@@ -26,6 +26,7 @@
 #include "eixTk/ptr_container.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 #include "portage/keywords.h"
 #include "portage/mask.h"
 #include "portage/package.h"
@@ -59,18 +60,115 @@ template<typename m_Type> class Masks : protected eix::forward_list<m_Type> {
 };
 
 template<typename m_Type> class MaskList {
+	public:
+		typedef typename eix::ptr_container<std::vector<const m_Type *> > Get;
+
 	private:
 		typedef typename Masks<m_Type>::const_iterator m_const_iterator;
 		typedef typename std::map<std::string, Masks<m_Type> > FullType;
 		typedef typename FullType::const_iterator full_const_iterator;
-		typedef typename std::map<std::string, Masks<m_Type> > ExactType;
+		typedef UNORDERED_MAP<std::string, Masks<m_Type> > ExactType;
 		typedef typename ExactType::const_iterator exact_const_iterator;
+		typedef std::vector<full_const_iterator> FullList;
+		typedef UNORDERED_MAP<std::string, FullList> FullIndex;
 
 		ExactType exact_name;
 		FullType full_name;
 
+		/**
+		The entries of full_name (in their order) by their category (the
+		part up to the first slash), and those entries which have a
+		wildcard in the category.
+		This is calculated when needed after the last add().
+		**/
+		mutable FullIndex full_index;
+		mutable FullList full_any;
+		mutable bool indexed;
+
+		void calc_index() const {
+			indexed = true;
+			full_index.clear();
+			full_any.clear();
+			for(full_const_iterator it(full_name.begin());
+				likely(it != full_name.end()); ++it) {
+				std::string::size_type slash(it->first.find('/'));
+				if(it->first.find_first_of("*?[\\") < slash) {
+					full_any.PUSH_BACK(it);
+				} else {
+					full_index[it->first.substr(0, slash)].PUSH_BACK(it);
+				}
+			}
+		}
+
+		/**
+		@return the candidates of full_name in category besides full_any
+		**/
+		const FullList *full_candidates(const std::string& category) const {
+			if(unlikely(!indexed)) {
+				calc_index();
+			}
+			typename FullIndex::const_iterator it(full_index.find(category));
+			return ((it == full_index.end()) ? NULLPTR : &(it->second));
+		}
+
+		/**
+		Append to *l the masks of the matching entries of full_name
+		in the order of full_name
+		**/
+		ATTRIBUTE_NONNULL_ void get_wildcards(Get **l, const std::string& full, const std::string& category) const {
+			const FullList *candidates(full_candidates(category));
+			typename FullList::const_iterator any(full_any.begin());
+			if(candidates != NULLPTR) {
+				for(typename FullList::const_iterator it(candidates->begin());
+					likely(it != candidates->end()); ++it) {
+					for(; unlikely(any != full_any.end()) && ((*any)->first < (*it)->first); ++any) {
+						if(unlikely(match_full((*any)->first, full))) {
+							push_result(l, (*any)->second);
+						}
+					}
+					if(unlikely(match_full((*it)->first, full))) {
+						push_result(l, (*it)->second);
+					}
+				}
+			}
+			for(; unlikely(any != full_any.end()); ++any) {
+				if(unlikely(match_full((*any)->first, full))) {
+					push_result(l, (*any)->second);
+				}
+			}
+		}
+
+		Get *get_full(const std::string& full, const std::string& category) const {
+			if(empty()) {
+				return NULLPTR;
+			}
+			Get *l(NULLPTR);
+			if(!full_name.empty()) {
+				get_wildcards(&l, full, category);
+			}
+			exact_const_iterator it(exact_name.find(full));
+			if(it != exact_name.end()) {
+				push_result(&l, it->second);
+			}
+			return l;
+		}
+
 	public:
-		typedef typename eix::ptr_container<std::vector<const m_Type *> > Get;
+		MaskList() : indexed(false) {
+		}
+
+		/**
+		The index refers to the original, so it is not copied
+		**/
+		MaskList(const MaskList& m) : exact_name(m.exact_name), full_name(m.full_name), indexed(false) {
+		}
+
+		MaskList& operator=(const MaskList& m) {
+			exact_name = m.exact_name;
+			full_name = m.full_name;
+			indexed = false;
+			return *this;
+		}
 
 		bool empty() const {
 			return (exact_name.empty() && full_name.empty());
@@ -79,6 +177,7 @@ template<typename m_Type> class MaskList {
 		void clear() {
 			exact_name.clear();
 			full_name.clear();
+			indexed = false;
 		}
 
 		inline static bool match_full(const std::string& mask, const std::string& name) {
@@ -89,9 +188,21 @@ template<typename m_Type> class MaskList {
 			if(exact_name.count(full) != 0) {
 				return true;
 			}
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
+			if(full_name.empty()) {
+				return false;
+			}
+			const FullList *candidates(full_candidates(full.substr(0, full.find('/'))));
+			if(candidates != NULLPTR) {
+				for(typename FullList::const_iterator it(candidates->begin());
+					likely(it != candidates->end()); ++it) {
+					if(unlikely(match_full((*it)->first, full))) {
+						return true;
+					}
+				}
+			}
+			for(typename FullList::const_iterator it(full_any.begin());
+				likely(it != full_any.end()); ++it) {
+				if(unlikely(match_full((*it)->first, full))) {
 					return true;
 				}
 			}
@@ -112,18 +223,7 @@ template<typename m_Type> class MaskList {
 		}
 
 		Get *get_full(const std::string& full) const {
-			Get *l(NULLPTR);
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					push_result(&l, it->second);
-				}
-			}
-			exact_const_iterator it(exact_name.find(full));
-			if(it != exact_name.end()) {
-				push_result(&l, it->second);
-			}
-			return l;
+			return get_full(full, full.substr(0, full.find('/')));
 		}
 
 		Get *get_setname(const std::string& setname) const {
@@ -131,7 +231,10 @@ template<typename m_Type> class MaskList {
 		}
 
 		ATTRIBUTE_NONNULL_ Get *get(const Package *p) const {
-			return get_full(p->category + "/" + p->name);
+			if(empty()) {
+				return NULLPTR;
+			}
+			return get_full(p->category + "/" + p->name, p->category);
 		}
 
 		void add(const m_Type& m) {
@@ -142,6 +245,7 @@ template<typename m_Type> class MaskList {
 				exact_name[full].add(m);
 				return;
 			}
+			indexed = false;
 			full_name[full].add(m);
 		}
 
@@ -289,10 +393,15 @@ class PreList : public std::vector<PreListEntry> {
 		Order order;
 		typedef std::vector<PreListFilename> FileNames;
 		FileNames filenames;
-		typedef std::map<std::vector<std::string>, Order::size_type> Have;
+		/**
+		The lines are hashed in the form returned by have_key()
+		**/
+		typedef UNORDERED_MAP<std::string, Order::size_type> Have;
 		Have have;
 		bool finalized;
 
+		ATTRIBUTE_NONNULL_ static void have_key(std::string *key, const std::vector<std::string>& line);
+
 	public:
 		void clear() {
 			finalize();
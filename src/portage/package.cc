@@ -48,14 +48,16 @@ void Package::addVersionStart(Version *version) {
 		DUP_NONE : ((version->overlay_key != 0) ? DUP_OVERLAYS :
 				((have_duplicate_versions == DUP_SOME) ?
 					DUP_NONE : DUP_SOME)));
-	bool have_inserted(false);
+	// Do not insert during the loop: This would invalidate the iterators
+	iterator where(end());
+	bool have_where(false);
 	for(iterator i(begin()); likely(i != end()); ++i) {
-		if(!have_inserted && (*version < **i)) {
-			insert(i, version);
+		if(!have_where && (*version < **i)) {
+			where = i;
+			have_where = true;
 			if(check_duplicates == DUP_NONE) {
-				return;
+				break;
 			}
-			have_inserted = true;
 		}
 		if((check_duplicates == DUP_NONE) ||
 			likely(BasicVersion::compare(**i, *version) != 0)) {
@@ -63,8 +65,8 @@ void Package::addVersionStart(Version *version) {
 		}
 		if(check_duplicates == DUP_SOME) {
 			have_duplicate_versions = DUP_SOME;
-			if(likely(have_inserted)) {
-				return;
+			if(likely(have_where)) {
+				break;
 			}
 			check_duplicates = DUP_NONE;
 			continue;
@@ -72,18 +74,15 @@ void Package::addVersionStart(Version *version) {
 		// checkDuplicates == DUP_OVERLAYS
 		if(i->overlay_key) {
 			have_duplicate_versions = DUP_OVERLAYS;
-			if(likely(have_inserted)) {
-				return;
+			if(likely(have_where)) {
+				break;
 			}
 			check_duplicates = DUP_NONE;
 		} else {
 			have_duplicate_versions = DUP_SOME;
 		}
 	}
-	if(unlikely(have_inserted)) {
-		return;
-	}
-	PUSH_BACK(MOVE(version));
+	insert(where, version);
 }
 
 void Package::collect_iuse(Version *version) {
@@ -12,7 +12,6 @@
 
 #include <config.h>  // IWYU pragma: keep
 
-#include <list>
 #include <string>
 #include <vector>
 
@@ -25,6 +24,7 @@
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/ptr_container.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/unordered_map.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -83,8 +83,10 @@ class SlotList : public std::vector<SlotVersions> {
 /**
 A class to represent a package in portage It contains various information
 about a package, including a sorted(!) list of versions.
+The versions are kept in a vector, since there are usually only a few,
+and they are scanned linearly much more often than they are inserted.
 **/
-class Package : public eix::ptr_container<std::list<Version *> > {
+class Package : public eix::ptr_container<std::vector<Version *> > {
 	public:
 		typedef std::vector<Version *> VerVec;
 
@@ -122,9 +124,10 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		eix::array<MaskFlags, Version::SAVEMASK_SIZE> saved_collects;
 
 		/**
-		Package properties (stored in db)
+		Package properties (stored in db); the category is shared
 		**/
-		std::string category, name, desc, homepage, licenses;
+		SharedString category;
+		std::string name, desc, homepage, licenses;
 
 		IUseSet iuse;
 
@@ -453,7 +456,7 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		Get the name of a slot/subslot of a version.
 		returns true if found.
 		**/
-		bool get_slotsubslot(const ExtendedVersion& v, std::string *slot, std::string *subslot) const;
+		bool get_slotsubslot(const ExtendedVersion& v, SharedString *slot, SharedString *subslot) const;
 
 		/**
 		Get the name of a slot of an installed version,
@@ -475,11 +478,10 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		@return is negative/0/positive if package is before/equal/after arg c
 		**/
 		int compare_catname(const Package& c) const {
-			int i(category.compare(c.category));
-			if(likely(i == 0)) {
+			if(likely(category == c.category)) {
 				return name.compare(c.name);
 			}
-			return i;
+			return category.compare(c.category);
 		}
 
 	protected:
@@ -495,7 +497,7 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		This is for caching in guess_slotname
 		**/
 		mutable bool m_has_cached_subslots, m_unique_subslot;
-		mutable std::string m_subslot;
+		mutable SharedString m_subslot;
 
 		/**
 		Create new slotlist. Const because we operate on mutable cache types.
@@ -20,6 +20,7 @@
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
 #include "portage/basicversion.h"
 #include "portage/conf/portagesettings.h"
 #include "portage/extendedversion.h"
@@ -190,7 +191,7 @@ bool Package::is_best_upgrade(bool check_slots, const Version *version, VarDbPkg
 	return false;
 }
 
-bool Package::get_slotsubslot(const ExtendedVersion& v, string *slot, string *subslot) const {
+bool Package::get_slotsubslot(const ExtendedVersion& v, SharedString *slot, SharedString *subslot) const {
 	for(const_iterator i(begin()); likely(i != end()); ++i) {
 		if(**i == v) {
 			*slot = i->slotname;
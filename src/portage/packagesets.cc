@@ -8,9 +8,75 @@
 #include "portage/packagesets.h"
 #include <config.h>  // IWYU pragma: keep
 
-#include <algorithm>
+#include <vector>
 
 #include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+
+const SetsIndex SetsBits::word_bits;
+
+bool SetsBits::has_more(SetsIndex i) const {
+	i -= word_bits;
+	Words::size_type w(i / word_bits);
+	if(w >= m_more.size()) {
+		return false;
+	}
+	return ((m_more[w] & (Word(1) << (i % word_bits))) != 0);
+}
+
+/**
+@return true if something has changed
+**/
+bool SetsBits::add(SetsIndex i) {
+	Word *word;
+	if(likely(i < word_bits)) {
+		word = &m_bits;
+	} else {
+		i -= word_bits;
+		Words::size_type w(i / word_bits);
+		if(w >= m_more.size()) {
+			m_more.resize(w + 1, 0);
+		}
+		word = &(m_more[w]);
+		i %= word_bits;
+	}
+	Word bit(Word(1) << i);
+	if((*word & bit) != 0) {
+		return false;
+	}
+	*word |= bit;
+	return true;
+}
+
+/**
+@return true if something has changed
+**/
+bool SetsBits::add(const SetsBits& b) {
+	Word old(m_bits);
+	m_bits |= b.m_bits;
+	bool r(old != m_bits);
+	if(unlikely(m_more.size() < b.m_more.size())) {
+		m_more.resize(b.m_more.size(), 0);
+	}
+	for(Words::size_type w(0); unlikely(w != b.m_more.size()); ++w) {
+		old = m_more[w];
+		m_more[w] |= b.m_more[w];
+		if(old != m_more[w]) {
+			r = true;
+		}
+	}
+	return r;
+}
+
+bool SetsBits::intersects_more(const SetsBits& b) const {
+	Words::size_type n((m_more.size() < b.m_more.size()) ? m_more.size() : b.m_more.size());
+	for(Words::size_type w(0); likely(w != n); ++w) {
+		if((m_more[w] & b.m_more[w]) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
 
 /**
 @return true if something has changed
@@ -22,15 +88,11 @@ bool SetsList::add_system() {
 	return (have_system = true);
 }
 
-bool SetsList::has(SetsIndex i) const {
-	return (std::find(begin(), end(), i) != end());
-}
-
 /**
 @return true if something has changed
 **/
 bool SetsList::add(SetsIndex i) {
-	if(has(i)) {
+	if(!m_bits.add(i)) {
 		return false;
 	}
 	PUSH_BACK(MOVE(i));
@@ -57,5 +119,6 @@ bool SetsList::add(const SetsList& l) {
 
 void SetsList::clear() {
 	super::clear();
+	m_bits.clear();
 	have_system = false;
 }
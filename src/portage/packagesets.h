@@ -16,12 +16,79 @@
 #include <string>
 
 #include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
 
 typedef std::vector<std::string>::size_type SetsIndex;
 
+/**
+Membership in local sets as a bitset: bit i stands for SetsIndex i.
+Since there are usually only few sets, the first bits are kept in a
+fixed-width word; only indices beyond are stored in m_more.
+**/
+class SetsBits {
+	public:
+		typedef uint64_t Word;
+		static CONSTEXPR const SetsIndex word_bits = 64;
+
+		SetsBits() : m_bits(0) {
+		}
+
+		bool empty() const {
+			return ((m_bits == 0) && likely(m_more.empty()));
+		}
+
+		bool has(SetsIndex i) const {
+			if(likely(i < word_bits)) {
+				return ((m_bits & (Word(1) << i)) != 0);
+			}
+			return has_more(i);
+		}
+
+		/**
+		@return true if something has changed
+		**/
+		bool add(SetsIndex i);
+
+		/**
+		@return true if something has changed
+		**/
+		bool add(const SetsBits& b);
+
+		/**
+		@return true if some set is in both bitsets
+		**/
+		bool intersects(const SetsBits& b) const {
+			if((m_bits & b.m_bits) != 0) {
+				return true;
+			}
+			if(likely(m_more.empty() || b.m_more.empty())) {
+				return false;
+			}
+			return intersects_more(b);
+		}
+
+		void clear() {
+			m_bits = 0;
+			m_more.clear();
+		}
+
+	private:
+		typedef std::vector<Word> Words;
+
+		Word m_bits;
+		Words m_more;
+
+		ATTRIBUTE_PURE bool has_more(SetsIndex i) const;
+
+		ATTRIBUTE_PURE bool intersects_more(const SetsBits& b) const;
+};
+
 class SetsList : public std::vector<SetsIndex> {
 	private:
 		bool have_system;
+		SetsBits m_bits;
 
 	public:
 		typedef std::vector<SetsIndex> super;
@@ -41,7 +108,16 @@ class SetsList : public std::vector<SetsIndex> {
 		**/
 		bool add_system();
 
-		ATTRIBUTE_PURE bool has(SetsIndex i) const;
+		bool has(SetsIndex i) const {
+			return m_bits.has(i);
+		}
+
+		/**
+		@return the (non-system) sets as a bitset
+		**/
+		const SetsBits& bits() const {
+			return m_bits;
+		}
 
 		/**
 		@return true if something has changed
@@ -252,14 +252,14 @@ bool VarDbPkg::readUse(const Package& p, InstVersion *v) const {
 		join_and_split(&alluse, lines);
 	}
 
-	IUseSet iuse_set;
 	for(WordVec::iterator it(inst_iuse.begin());
 		it != inst_iuse.end(); ++it) {
 		while(((*it)[0] == '+') || ((*it)[0] == '-')) {
 			it->erase(0, 1);
 		}
-		iuse_set.insert_fast(*it);
 	}
+	IUseSet iuse_set;
+	iuse_set.insert(inst_iuse);
 	IUseSet::IUseNaturalOrder ordered(iuse_set.asNaturalOrder());
 	inst_iuse.clear();
 	for(IUseSet::IUseNaturalOrder::const_iterator it(ordered.begin());
@@ -274,10 +274,9 @@ bool VarDbPkg::readUse(const Package& p, InstVersion *v) const {
 		}
 	}
 
-	IUseSet::IUseStd iuse_std(iuse_set.asStd());
 	for(WordVec::iterator it(alluse.begin());
 		likely(it != alluse.end()); ++it) {
-		if(iuse_std.count(IUse(*it)) != 0) {
+		if(iuse_set.has(*it)) {
 			v->usedUse.INSERT(MOVE(*it));
 		}
 	}
@@ -380,7 +379,7 @@ void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& head
 			}
 		}
 	}
-	v->depend.set(depend[0], depend[1], depend[2], depend[3], depend[4], true);
+	v->depend.set(depend[0], depend[1], depend[2], depend[3], depend[4]);
 }
 
 /**
@@ -10,6 +10,7 @@
 #include "portage/version.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <algorithm>
 #include <string>
 
 #include "eixTk/dialect.h"
@@ -104,10 +105,12 @@ string IUse::asString() const {
 
 IUseSet::IUseNaturalOrder IUseSet::asNaturalOrder() const {
 	IUseNaturalOrder ret;
+	ret.reserve(m_iuse.size());
 	for(IUseStd::const_iterator it(m_iuse.begin());
 		likely(it != m_iuse.end()); ++it) {
-		ret.insert(&(*it));
+		ret.PUSH_BACK(&(*it));
 	}
+	std::sort(ret.begin(), ret.end());
 	return ret;
 }
 
@@ -134,35 +137,87 @@ WordVec IUseSet::asVector() const {
 	return ret;
 }
 
+bool IUseSet::has(const string& name) const {
+	IUseStd::const_iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(),
+		IUse(name, IUse::USEFLAGS_NIL)));
+	return ((it != m_iuse.end()) && (it->name() == name));
+}
+
 void IUseSet::insert(const IUseStd& iuse) {
-	for(IUseStd::const_iterator it(iuse.begin());
-		likely(it != iuse.end()); ++it) {
-		insert(*it);
+	if(iuse.empty()) {
+		return;
 	}
+	if(m_iuse.empty()) {
+		m_iuse = iuse;
+		return;
+	}
+	// Both are sorted and unique: merge them
+	const IUseStd& curr(m_iuse);
+	IUseStd merged;
+	merged.reserve(curr.size() + iuse.size());
+	IUseStd::const_iterator a(curr.begin()), b(iuse.begin());
+	while((a != curr.end()) && (b != iuse.end())) {
+		if(*a < *b) {
+			merged.PUSH_BACK(*(a++));
+		} else if(*b < *a) {
+			merged.PUSH_BACK(*(b++));
+		} else {
+			merged.EMPLACE_BACK(IUse, (a->name(), a->flags | b->flags));
+			++a;
+			++b;
+		}
+	}
+	merged.insert(merged.end(), a, curr.end());
+	merged.insert(merged.end(), b, iuse.end());
+	m_iuse.swap(merged);
 }
 
 void IUseSet::insert(const string& iuse) {
 	WordVec vec;
 	split_string(&vec, iuse);
-	for(WordVec::const_iterator it(vec.begin());
-		likely(it != vec.end()); ++it) {
-		insert_fast(*it);
+	insert(vec);
+}
+
+void IUseSet::insert(const WordVec& iuse) {
+	IUseStd add;
+	add.reserve(iuse.size());
+	for(WordVec::const_iterator it(iuse.begin());
+		likely(it != iuse.end()); ++it) {
+		add.EMPLACE_BACK(IUse, (*it));
 	}
+	normalize(&add);
+	insert(add);
+}
+
+void IUseSet::assign(IUseStd *iuse) {
+	normalize(iuse);
+	m_iuse.swap(*iuse);
 }
 
 void IUseSet::insert(const IUse& iuse) {
-	IUseStd::iterator it(m_iuse.find(iuse));
-	if(it == m_iuse.end()) {
-		m_iuse.insert(iuse);
+	IUseStd::iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(), iuse));
+	if((it == m_iuse.end()) || (*it != iuse)) {
+		m_iuse.insert(it, iuse);
 		return;
 	}
-	IUse::Flags oriflags(it->flags);
-	IUse::Flags newflags(oriflags | (iuse.flags));
-	if(newflags == oriflags) {
+	it->flags |= iuse.flags;
+}
+
+void IUseSet::normalize(IUseStd *iuse) {
+	if(iuse->size() < 2) {
 		return;
 	}
-	m_iuse.erase(it);
-	m_iuse.EMPLACE(IUse, (iuse.name(), newflags));
+	std::sort(iuse->begin(), iuse->end());
+	IUseStd::iterator dest(iuse->begin());
+	for(IUseStd::iterator it(dest + 1); likely(it != iuse->end()); ++it) {
+		if(*dest == *it) {
+			dest->flags |= it->flags;
+		} else if(++dest != it) {
+			dest->swap(*it);
+			dest->flags = it->flags;
+		}
+	}
+	iuse->erase(++dest, iuse->end());
 }
 
 const Version::EffectiveState
@@ -12,7 +12,6 @@
 
 #include <config.h>  // IWYU pragma: keep
 
-#include <algorithm>
 #include <set>
 #include <string>
 #include <vector>
@@ -86,8 +85,7 @@ class IUse : public std::string {
 
 class IUseNatural {
 	public:
-		IUseNatural(const IUse *use) {
-			m_iuse = use;
+		IUseNatural(const IUse *use) NOEXCEPT : m_iuse(use) {
 		}
 
 		const IUse& iuse() const {
@@ -125,10 +123,14 @@ class IUseNatural {
 		const IUse *m_iuse;
 };
 
+/**
+The IUSE of a version or package, kept as a vector sorted by name
+without duplicates: This needs much fewer allocations than a tree.
+**/
 class IUseSet {
 	public:
-		typedef std::set<IUse> IUseStd;
-		typedef std::set<IUseNatural> IUseNaturalOrder;
+		typedef std::vector<IUse> IUseStd;
+		typedef std::vector<IUseNatural> IUseNaturalOrder;
 
 		bool empty() const {
 			return m_iuse.empty();
@@ -144,6 +146,11 @@ class IUseSet {
 
 		IUseNaturalOrder asNaturalOrder() const;
 
+		/**
+		@return true if the name of some entry is name
+		**/
+		bool has(const std::string& name) const;
+
 		void insert(const IUseStd& iuse);
 
 		void insert(const IUseSet& iuse) {
@@ -152,10 +159,18 @@ class IUseSet {
 
 		void insert(const std::string& iuse);
 
+		void insert(const WordVec& iuse);
+
 		void insert_fast(const std::string& iuse) {
 			insert(IUse(iuse));
 		}
 
+		/**
+		Replace the content by the entries of *iuse which need not be
+		sorted or unique; *iuse is left in an unspecified state
+		**/
+		ATTRIBUTE_NONNULL_ void assign(IUseStd *iuse);
+
 		std::string asString() const;
 
 		WordVec asVector() const;
@@ -164,6 +179,11 @@ class IUseSet {
 		IUseStd m_iuse;
 
 		void insert(const IUse& iuse);
+
+		/**
+		Sort *iuse by name and join the flags of equal names
+		**/
+		ATTRIBUTE_NONNULL_ static void normalize(IUseStd *iuse);
 };
 
 /**
@@ -202,9 +222,18 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 		eix::array<std::string, SAVEEFFECTIVE_SIZE>  saved_accepted;
 		eix::array<EffectiveState, EFFECTIVE_UNUSED> states_effective;
 
+		/**
+		The local sets of the version in the order in which they were
+		added; this order is used when set-specific masks are applied
+		**/
 		typedef std::vector<SetsIndex> SetsIndizes;
 		SetsIndizes sets_indizes;
 
+		/**
+		The same sets for fast membership tests
+		**/
+		SetsBits sets_bits;
+
 		std::string m_accepted_keywords;
 
 		IUseSet iuse;
@@ -280,11 +309,11 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 		}
 
 		bool is_in_set(SetsIndex m_set) const {
-			return (std::find(sets_indizes.begin(), sets_indizes.end(), m_set) != sets_indizes.end());
+			return sets_bits.has(m_set);
 		}
 
 		void add_to_set(SetsIndex m_set) {
-			if(!is_in_set(m_set)) {
+			if(sets_bits.add(m_set)) {
 				sets_indizes.PUSH_BACK(MOVE(m_set));
 			}
 		}
@@ -326,6 +355,14 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 			keyflags.set_keyflags(get_keyflags(accepted_keywords));
 		}
 
+		ATTRIBUTE_NONNULL_ KeywordsFlags::KeyType get_keyflags(KeyflagsMemo *memo) const {
+			return memo->get_keyflags((effective_state == EFFECTIVE_USED) ? effective_keywords : full_keywords);
+		}
+
+		ATTRIBUTE_NONNULL_ void set_keyflags(KeyflagsMemo *memo) {
+			keyflags.set_keyflags(get_keyflags(memo));
+		}
+
 		void add_reason(const StringList& reason);
 
 		ATTRIBUTE_NONNULL_ void reasons_string(OutputString *s, const OutputString& skip, const OutputString& sep) const;
@@ -35,39 +35,58 @@ fnmatch(3) tells that this is a GNU extension.
 using std::string;
 
 FuzzyAlgorithm::LevenshteinMap *FuzzyAlgorithm::levenshtein_map = NULLPTR;
-
-bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
-	if(can_simplify() && unlikely(!have_simplified) && likely(simplify)) {
-		have_simplified = true;
-		// cut out the first nonempty valid search string
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(likely(is_valid_pkgpath(search_string[i]))) {
-				if(unlikely(i > 0)) {
-					search_string.erase(0, i);
-				}
-				break;
+FuzzyAlgorithm::LevenshteinMap *FuzzyAlgorithm::default_levenshtein_map = NULLPTR;
+bool FuzzyAlgorithm::used = false;
+
+void BaseAlgorithm::simplify(string *s) {
+	for(string::size_type i = 0; i < s->length(); ++i) {
+		if(likely(is_valid_pkgpath((*s)[i]))) {
+			if(unlikely(i > 0)) {
+				s->erase(0, i);
 			}
+			break;
 		}
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(unlikely(!is_valid_pkgpath(search_string[i]))) {
-				if(likely(i > 0)) {
-					search_string.erase(i);
-				}
-				break;
+	}
+	for(string::size_type i = 0; i < s->length(); ++i) {
+		if(unlikely(!is_valid_pkgpath((*s)[i]))) {
+			if(likely(i > 0)) {
+				s->erase(i);
 			}
+			break;
 		}
 	}
+}
+
+bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
+	if(can_simplify() && unlikely(!have_simplified) && likely(simplify)) {
+		have_simplified = true;
+		BaseAlgorithm::simplify(&search_string);
+	}
 	return (*this)(s, p);
 }
 
+/**
+The simplified search string is a substring of the original one,
+hence it is contained in every match (simplified or not).
+**/
+bool BaseAlgorithm::literal(string *lit) const {
+	*lit = search_string;
+	if(can_simplify()) {
+		simplify(lit);
+	}
+	return !lit->empty();
+}
+
 void FuzzyAlgorithm::init_static() {
-	eix_assert_static(levenshtein_map == NULLPTR);
-	levenshtein_map = new LevenshteinMap;
+	eix_assert_static(default_levenshtein_map == NULLPTR);
+	levenshtein_map = default_levenshtein_map = new LevenshteinMap;
 }
 
 bool FuzzyAlgorithm::compare(Package *p1, Package *p2) {
-	return ((*levenshtein_map)[p1->category + "/" + p1->name]
-			< (*levenshtein_map)[p2->category + "/" + p2->name]);
+	LevenshteinMap::const_iterator d1(levenshtein_map->find(p1));
+	LevenshteinMap::const_iterator d2(levenshtein_map->find(p2));
+	return (((d1 == levenshtein_map->end()) ? 0 : d1->second)
+			< ((d2 == levenshtein_map->end()) ? 0 : d2->second));
 }
 
 
@@ -77,7 +96,7 @@ bool FuzzyAlgorithm::operator()(const char *s, Package *p) const {
 	bool ok(d <= max_levenshteindistance);
 	if(ok) {
 		if(p != NULLPTR) {
-			(*levenshtein_map)[p->category + "/" + p->name] = d;
+			(*levenshtein_map)[p] = d;
 		}
 	}
 	return ok;
@@ -103,3 +122,56 @@ bool EndAlgorithm::operator()(const char *s, Package * /* p */) const {
 bool PatternAlgorithm::operator()(const char *s, Package * /* p */) const {
 	return (fnmatch(search_string.c_str(), s, FNMATCH_FLAGS) == 0);
 }
+
+/**
+Use the longest part of the pattern without wildcards or bracket expressions
+**/
+bool PatternAlgorithm::literal(string *lit) const {
+	lit->clear();
+	string curr;
+	for(const char *p(search_string.c_str()); ; ++p) {
+		char c(*p);
+		if(c == '\\') {
+			if(likely(p[1] != '\0')) {
+				curr.append(1, *(++p));
+				continue;
+			}
+		} else if((c != '\0') && (c != '*') && (c != '?') && (c != '[')) {
+			curr.append(1, c);
+			continue;
+		}
+		if(curr.size() > lit->size()) {
+			lit->swap(curr);
+		}
+		curr.clear();
+		if(c == '\0') {
+			break;
+		}
+		if(c == '[') {
+			// skip the bracket expression
+			const char *q(p + 1);
+			if((*q == '!') || (*q == '^')) {
+				++q;
+			}
+			if(*q == ']') {
+				++q;
+			}
+			for(; (*q != '\0') && (*q != ']'); ++q) {
+				if((*q == '[') && ((q[1] == ':') || (q[1] == '=') || (q[1] == '.'))) {
+					const char delim(q[1]);
+					for(q += 2; (*q != '\0') && ((*q != delim) || (q[1] != ']')); ++q) {
+					}
+					if(*q == '\0') {
+						break;
+					}
+					++q;
+				}
+			}
+			if(*q == '\0') {
+				break;
+			}
+			p = q;
+		}
+	}
+	return !lit->empty();
+}
@@ -16,6 +16,7 @@
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/null.h"
 #include "eixTk/regexp.h"
 #include "eixTk/unordered_map.h"
 #include "search/levenshtein.h"
@@ -37,6 +38,11 @@ class BaseAlgorithm {
 			return true;
 		}
 
+		/**
+		Cut out the first nonempty valid part of a package path
+		**/
+		ATTRIBUTE_NONNULL_ static void simplify(std::string *s);
+
 	public:
 		virtual void setString(const std::string& s) {
 			search_string = s;
@@ -49,6 +55,30 @@ class BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) virtual bool operator()(const char *s, Package *p) const = 0;
 
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p, bool simplify);
+
+		/**
+		Set *lit to a string which is contained in every matching string.
+		The default is the (simplified) search string for literal matching.
+		@return false if no such string is known
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool literal(std::string *lit) const;
+
+		/**
+		Set *s and *max if a match requires Levenshtein distance at most
+		*max from *s.
+		@return false if this is not known
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool neighbourhood(std::string * /* s */, Levenshtein * /* max */) const {
+			return false;
+		}
+
+		/**
+		@return true if matching has side effects so that the order
+		of evaluation must not be changed
+		**/
+		virtual bool has_side_effects() const {
+			return false;
+		}
 };
 
 /**
@@ -71,6 +101,11 @@ class RegexAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
 			return re.match(s);
 		}
+
+		ATTRIBUTE_NONNULL_ bool literal(std::string *lit) const OVERRIDE {
+			*lit = re.literal();
+			return !lit->empty();
+		}
 };
 
 /**
@@ -112,16 +147,26 @@ Store distance to searchstring in Package and sort out packages with a
 higher distance than max_levenshteindistance.
 **/
 class FuzzyAlgorithm FINAL : public BaseAlgorithm {
+	public:
+		/**
+		The distances of the matching packages for the static
+		FuzzyAlgorithm::compare.
+		The packages are the keys so that no strings need to be built.
+		**/
+		typedef UNORDERED_MAP<const Package *, Levenshtein> LevenshteinMap;
+
 	protected:
 		Levenshtein max_levenshteindistance;
 
 		/**
-		FIXME: We need to have a package->levenshtein mapping that we can
-		access from the static FuzzyAlgorithm::compare.
-		I really don't know how to do this ..
+		The map in which the distances are currently recorded
 		**/
-		typedef UNORDERED_MAP<std::string, Levenshtein> LevenshteinMap;
-		static LevenshteinMap *levenshtein_map;
+		static LevenshteinMap *levenshtein_map, *default_levenshtein_map;
+
+		/**
+		Was some FuzzyAlgorithm constructed?
+		**/
+		static bool used;
 
 		bool can_simplify() const OVERRIDE {
 			return false;
@@ -129,16 +174,50 @@ class FuzzyAlgorithm FINAL : public BaseAlgorithm {
 
 	public:
 		explicit FuzzyAlgorithm(Levenshtein max) : max_levenshteindistance(max) {
+			used = true;
 		}
 
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p) const OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ bool literal(std::string * /* lit */) const OVERRIDE {
+			return false;
+		}
+
+		ATTRIBUTE_NONNULL_ bool neighbourhood(std::string *s, Levenshtein *max) const OVERRIDE {
+			*s = search_string;
+			*max = max_levenshteindistance;
+			return true;
+		}
+
+		/**
+		Matching records the distance for sorting
+		**/
+		bool has_side_effects() const OVERRIDE {
+			return true;
+		}
+
 		ATTRIBUTE_NONNULL_ static bool compare(Package *p1, Package *p2);
 
+		/**
+		Record the distances of subsequent matches in m which is also used
+		by compare(), so that each query of a batch can have its own map.
+		NULLPTR restores the default map.
+		**/
+		static void set_levenshtein_map(LevenshteinMap *m) {
+			levenshtein_map = ((m == NULLPTR) ? default_levenshtein_map : m);
+		}
+
 		static bool sort_by_levenshtein() {
 			return (!levenshtein_map->empty());
 		}
 
+		/**
+		@return false if the matches will certainly not be sorted
+		**/
+		static bool might_sort() {
+			return used;
+		}
+
 		static void init_static();
 };
 
@@ -153,6 +232,8 @@ class PatternAlgorithm FINAL : public BaseAlgorithm {
 
 	public:
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		ATTRIBUTE_NONNULL_ bool literal(std::string *lit) const OVERRIDE;
 };
 
 #endif  // SRC_SEARCH_ALGORITHMS_H_
@@ -14,7 +14,10 @@
 #include <cstdlib>
 #endif
 
+#include <algorithm>
 #include <stack>
+#include <utility>
+#include <vector>
 
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
@@ -22,6 +25,9 @@
 #include "eixTk/null.h"
 #include "search/packagetest.h"
 
+using std::pair;
+using std::vector;
+
 bool MatchAtom::match(PackageReader * /* p */) {
 #ifdef DEBUG_MATCHTREE
 	eix::print(m_negate ? " '!' " : " '' ");
@@ -68,6 +74,88 @@ bool MatchAtomOperator::match(PackageReader *p) {
 	return is_match;
 }
 
+bool MatchAtomOperator::candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *installed) {
+	if(m_negate || (m_left == NULLPTR) || (m_right == NULLPTR)) {
+		return false;
+	}
+	bool have_left(m_left->candidates(index, set, installed));
+	if(m_operator == AtomOr) {
+		if(!have_left) {
+			return false;
+		}
+		TrigramIndex::PackageSet right;
+		if(!m_right->candidates(index, &right, installed)) {
+			return false;
+		}
+		for(TrigramIndex::PackageSet::size_type i(0); likely(i != set->size()); ++i) {
+			if(right[i]) {
+				(*set)[i] = true;
+			}
+		}
+		return true;
+	}
+	if(!have_left) {
+		return m_right->candidates(index, set, installed);
+	}
+	TrigramIndex::PackageSet right;
+	if(m_right->candidates(index, &right, installed)) {
+		for(TrigramIndex::PackageSet::size_type i(0); likely(i != set->size()); ++i) {
+			if(!right[i]) {
+				(*set)[i] = false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+Collect the operands of the maximal chain of non-negated operators of the
+same kind, i.e. of the operands which may be evaluated in any order
+**/
+void MatchAtomOperator::collect_chain(vector<MatchAtomOperator *> *ops, vector<MatchAtom *> *operands) {
+	MatchAtom *children[2] = { m_left, m_right };
+	for(unsigned int i(0); i != 2; ++i) {
+		MatchAtomOperator *o((children[i] == NULLPTR) ? NULLPTR : children[i]->as_operator());
+		if((o != NULLPTR) && !(o->m_negate) && (o->m_operator == m_operator)) {
+			ops->push_back(o);
+			o->collect_chain(ops, operands);
+		} else {
+			operands->push_back(children[i]);
+		}
+	}
+}
+
+/**
+A missing operand counts as true, so it may be moved as well.
+The chain is rebuilt left-deep with the cheapest operand evaluated first.
+**/
+PackageTest::Cost MatchAtomOperator::plan(bool *pinned) {
+	vector<MatchAtomOperator *> ops(1, this);
+	vector<MatchAtom *> operands;
+	collect_chain(&ops, &operands);
+	bool keep(false);
+	PackageTest::Cost total(0);
+	vector<pair<PackageTest::Cost, vector<MatchAtom *>::size_type> > order;
+	for(vector<MatchAtom *>::size_type i(0); likely(i != operands.size()); ++i) {
+		PackageTest::Cost c((operands[i] == NULLPTR) ? 0 : operands[i]->plan(&keep));
+		total += c;
+		order.push_back(pair<PackageTest::Cost, vector<MatchAtom *>::size_type>(c, i));
+	}
+	if(keep) {
+		*pinned = true;
+		return total;
+	}
+	// Ties are kept in their original order by comparing the indices
+	std::sort(order.begin(), order.end());
+	vector<MatchAtom *>::size_type last(operands.size() - 1);
+	for(vector<MatchAtomOperator *>::size_type k(0); likely(k != last); ++k) {
+		ops[k]->m_right = operands[order[last - k].second];
+		ops[k]->m_left = ((k + 1 == last) ?
+			operands[order[0].second] : ops[k + 1]);
+	}
+	return total;
+}
+
 MatchAtomTest::~MatchAtomTest() {
 #ifndef DEBUG_MATCHTREE
 	delete m_test;
@@ -100,6 +188,39 @@ bool MatchAtomTest::match(PackageReader *p) {
 #endif
 }
 
+/**
+A pipe can only restrict further, so it is ignored
+**/
+bool MatchAtomTest::candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *installed) {
+#ifdef DEBUG_MATCHTREE
+	return false;
+#else
+	return (likely(!m_negate) && likely(m_test != NULLPTR) &&
+		m_test->candidates(index, set, installed));
+#endif
+}
+
+/**
+The pipe is evaluated before the test
+**/
+PackageTest::Cost MatchAtomTest::plan(bool *pinned) {
+#ifdef DEBUG_MATCHTREE
+	return 0;
+#else
+	PackageTest::Cost c(0);
+	if(unlikely((m_pipe != NULLPTR) && (*m_pipe != NULLPTR))) {
+		c = (*m_pipe)->plan(pinned);
+	}
+	if(likely(m_test != NULLPTR)) {
+		c += m_test->cost();
+		if(unlikely(m_test->pinned())) {
+			*pinned = true;
+		}
+	}
+	return c;
+#endif
+}
+
 void MatchAtomTest::set_test(PackageTest *gtest) {
 #ifdef DEBUG_MATCHTREE
 	static int t_count(0);
@@ -132,6 +253,17 @@ bool MatchTree::match(PackageReader *p) {
 	return ((root == NULLPTR) || root->match(p));
 }
 
+bool MatchTree::candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *installed) {
+	return ((root != NULLPTR) && root->candidates(index, set, installed));
+}
+
+void MatchTree::plan() {
+	bool pinned(false);
+	if(root != NULLPTR) {
+		root->plan(&pinned);
+	}
+}
+
 void MatchTree::set_pipetest(PackageTest *gtest) {
 	MatchAtomTest *p(new MatchAtomTest);
 	p->set_test(gtest);
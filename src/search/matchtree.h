@@ -11,16 +11,18 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <stack>
+#include <vector>
 
+#include "database/trigram.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/null.h"
+#include "search/packagetest.h"
 
 class MatchAtomOperator;
 class MatchAtomTest;
 class MatchTree;
 class PackageReader;
-class PackageTest;
 
 class MatchAtom {
 		friend class MatchTree;
@@ -47,6 +49,26 @@ class MatchAtom {
 		**/
 		ATTRIBUTE_PURE virtual bool match(PackageReader *p);
 
+		/**
+		Restrict (recursively if necessary) the packages which can match.
+		@param installed is set if also installed packages outside of set
+		might match
+		@return false if no restriction is possible
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool candidates(SearchIndex * /* index */, TrigramIndex::PackageSet * /* set */, bool * /* installed */) {
+			return false;
+		}
+
+		/**
+		Reorder (recursively if necessary) the operands of commutative
+		operators such that cheap tests are evaluated first.
+		@param pinned is set if the order of evaluation must be kept
+		@return estimated cost of match()
+		**/
+		ATTRIBUTE_NONNULL_ virtual PackageTest::Cost plan(bool * /* pinned */) {
+			return 0;
+		}
+
 		virtual MatchAtomOperator *as_operator() {
 			return NULLPTR;
 		}
@@ -63,6 +85,8 @@ class MatchAtomOperator : public MatchAtom {
 		AtomOperator m_operator;
 		MatchAtom *m_left, *m_right;
 
+		ATTRIBUTE_NONNULL_ void collect_chain(std::vector<MatchAtomOperator *> *ops, std::vector<MatchAtom *> *operands);
+
 	public:
 		explicit MatchAtomOperator(AtomOperator op)
 			: m_operator(op), m_left(NULLPTR), m_right(NULLPTR) {
@@ -72,6 +96,10 @@ class MatchAtomOperator : public MatchAtom {
 
 		bool match(PackageReader *p) OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ bool candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *installed) OVERRIDE;
+
+		ATTRIBUTE_NONNULL_ PackageTest::Cost plan(bool *pinned) OVERRIDE;
+
 		MatchAtomOperator *as_operator() OVERRIDE {
 			return this;
 		}
@@ -91,6 +119,10 @@ class MatchAtomTest : public MatchAtom {
 
 		bool match(PackageReader *p) OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ bool candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *installed) OVERRIDE;
+
+		ATTRIBUTE_NONNULL_ PackageTest::Cost plan(bool *pinned) OVERRIDE;
+
 		void set_test(PackageTest *gtest);
 
 		MatchAtomTest *as_test() OVERRIDE {
@@ -176,6 +208,20 @@ class MatchTree {
 
 		bool match(PackageReader *p);
 
+		/**
+		Restrict the packages which can match with the aid of index.
+		@param installed is set if also installed packages outside of set
+		might match
+		@return false if no restriction is possible
+		**/
+		ATTRIBUTE_NONNULL_ bool candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *installed);
+
+		/**
+		Reorder the tests such that cheap tests are evaluated first.
+		This does not change the result of match().
+		**/
+		void plan();
+
 		void set_pipetest(PackageTest *gtest);
 
 		void parse_test(PackageTest *gtest, bool with_pipe);
@@ -11,8 +11,12 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
+#include "database/fuzzy.h"
 #include "database/package_reader.h"
+#include "database/revdep.h"
+#include "database/trigram.h"
 #include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
 #include "eixTk/filenames.h"
@@ -31,11 +35,14 @@
 #include "portage/extendedversion.h"
 #include "portage/mask_list.h"
 #include "portage/package.h"
+#include "portage/packagesets.h"
 #include "portage/vardbpkg.h"
 #include "search/algorithms.h"
+#include "search/levenshtein.h"
 #include "search/nowarn.h"
 
 using std::string;
+using std::vector;
 
 class DBHeader;
 class SetStability;
@@ -98,6 +105,7 @@ NowarnMaskList *PackageTest::nowarn_list = NULLPTR;
 
 ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static bool stabilitytest(const Package *p, PackageTest::TestStability what);
 ATTRIBUTE_NONNULL_ inline static void get_p(Package **p, PackageReader *pkg);
+ATTRIBUTE_NONNULL_ static void intersect(TrigramIndex::PackageSet *set, const TrigramIndex::PackageSet& other);
 
 PackageTest::PackageTest(VarDbPkg *vdb, PortageSettings *p, const PrintFormat *f, const SetStability *set_stability, const DBHeader *dbheader, const ParseError *e) {
 	vardbpkg = vdb;
@@ -110,10 +118,13 @@ PackageTest::PackageTest(VarDbPkg *vdb, PortageSettings *p, const PrintFormat *f
 	algorithm = NULLPTR;
 	from_overlay_inst_list = NULLPTR;
 	from_foreign_overlay_inst_list = NULLPTR;
+	required_by_list = NULLPTR;
+	required_by_classes = Depend::CLASS_ALL;
 	marked_list = NULLPTR;
 
 	field = NONE;
 	need = PackageReader::NONE;
+	estimated_cost = COST_NAME;
 	overlay = obsolete = upgrade = installed = multi_installed =
 		slotted = multi_slot =
 		world = world_only_selected = world_only_file =
@@ -136,12 +147,16 @@ PackageTest::~PackageTest() {
 	delete in_overlay_inst_list;
 	delete from_overlay_inst_list;
 	delete from_foreign_overlay_inst_list;
+	delete required_by_list;
 }
 
 void PackageTest::calculateNeeds() {
 	need = PackageReader::NONE;
-	if((field & (SRC_URI | EAPI | SLOT | FULLSLOT | SET)) != NONE) {
-		setNeeds(PackageReader::VERSIONS);
+	if((field & SET) != NONE) {
+		setNeeds(PackageReader::SETS);
+	}
+	if((field & (SRC_URI | EAPI | SLOT | FULLSLOT)) != NONE) {
+		setNeeds(PackageReader::VERSIONS_RAW);
 	}
 	if((field & HOMEPAGE) != NONE) {
 		setNeeds(PackageReader::HOMEPAGE);
@@ -167,24 +182,29 @@ void PackageTest::calculateNeeds() {
 	if(!Depend::use_depend) {
 		field &= ~DEPSA;
 	}
+	// These tests need only the data of the versions stored in the database
 	if(((field & (IUSE | DEPSA)) != NONE) ||
-		dup_packages || dup_versions || slotted ||
-		upgrade || overlay || obsolete ||
-		world || worldset ||
+		dup_packages || dup_versions || slotted || overlay ||
 		have_virtual || have_nonvirtual ||
 		(from_overlay_inst_list != NULLPTR) ||
 		(from_foreign_overlay_inst_list != NULLPTR) ||
 		(overlay_list != NULLPTR) || (overlay_only_list != NULLPTR) ||
 		(in_overlay_inst_list != NULLPTR) ||
+		(required_by_list != NULLPTR) ||
 		(marked_list != NULLPTR) ||
 		(restrictions != ExtendedVersion::RESTRICT_NONE) ||
 		(properties != ExtendedVersion::PROPERTIES_NONE) ||
-		(binarynum != 0) ||
+		(binarynum != 0)) {
+		setNeeds(PackageReader::VERSIONS_RAW);
+	}
+	// These tests need the world sets or masks
+	if(upgrade || obsolete || world || worldset ||
 		(test_instability != STABLE_NONE) ||
 		(test_stability_default != STABLE_NONE) ||
 		(test_stability_local != STABLE_NONE) ||
-		(test_stability_nonlocal != STABLE_NONE))
+		(test_stability_nonlocal != STABLE_NONE)) {
 		setNeeds(PackageReader::VERSIONS);
+	}
 }
 
 void PackageTest::finalize() {
@@ -192,6 +212,61 @@ void PackageTest::finalize() {
 		setPattern("");
 	}
 	calculateNeeds();
+	calculateCost();
+	calculateSetMatches();
+}
+
+/**
+The names of the local sets do not change, so we match them only once
+**/
+void PackageTest::calculateSetMatches() {
+	set_matches.clear();
+	if((field & SET) == NONE) {
+		return;
+	}
+	const WordVec& names(portagesettings->set_names);
+	for(SetsIndex i(0); likely(i != names.size()); ++i) {
+		if((*algorithm)(names[i].c_str(), NULLPTR)
+		|| (*algorithm)((string("@") + names[i]).c_str(), NULLPTR)) {
+			set_matches.add(i);
+		}
+	}
+}
+
+void PackageTest::calculateCost() {
+	if(need >= PackageReader::VERSIONS_RAW) {
+		estimated_cost = COST_VERSIONS;
+	} else if(need > PackageReader::NAME) {
+		estimated_cost = COST_TEXT;
+	} else {
+		estimated_cost = COST_NAME;
+	}
+	if(upgrade || obsolete || world || worldset ||
+		(test_instability != STABLE_NONE) ||
+		(test_stability_default != STABLE_NONE) ||
+		(test_stability_local != STABLE_NONE) ||
+		(test_stability_nonlocal != STABLE_NONE)) {
+		estimated_cost += COST_STABILITY;
+	}
+	if(((field & (USE_ENABLED | USE_DISABLED | INST_EAPI | INST_SLOT | INST_FULLSLOT | DEPSI)) != NONE) ||
+		installed || upgrade || obsolete ||
+		(in_overlay_inst_list != NULLPTR) ||
+		(from_overlay_inst_list != NULLPTR) ||
+		(from_foreign_overlay_inst_list != NULLPTR) ||
+		(restrictions != ExtendedVersion::RESTRICT_NONE) ||
+		(properties != ExtendedVersion::PROPERTIES_NONE) ||
+		(binarynum != 0) ||
+		(test_instability != STABLE_NONE)) {
+		estimated_cost += COST_VARDB;
+	}
+}
+
+/**
+The obsolete tests modify the redundancy flags of the package
+**/
+bool PackageTest::pinned() const {
+	return (obsolete ||
+		((algorithm != NULLPTR) && algorithm->has_side_effects()));
 }
 
 /**
@@ -267,13 +342,10 @@ bool PackageTest::stringMatch(Package *pkg) const {
 		}
 	}
 
-	if((field & SET) != NONE) {
-		WordSet setnames;
-		portagesettings->get_setnames(&setnames, pkg);
-		for(WordSet::const_iterator it(setnames.begin());
-			likely(it != setnames.end()); ++it) {
-			if((*algorithm)(it->c_str(), NULLPTR)
-			|| (*algorithm)((string("@") + *it).c_str(), NULLPTR)) {
+	if(((field & SET) != NONE) && !set_matches.empty()) {
+		for(Package::const_iterator it(pkg->begin());
+			likely(it != pkg->end()); ++it) {
+			if(it->sets_bits.intersects(set_matches)) {
 				return true;
 			}
 		}
@@ -381,6 +453,77 @@ bool PackageTest::stringMatch(Package *pkg) const {
 	return false;
 }
 
+static void intersect(TrigramIndex::PackageSet *set, const TrigramIndex::PackageSet& other) {
+	for(TrigramIndex::PackageSet::size_type i(0); likely(i != set->size()); ++i) {
+		if((i < other.size()) && !other[i]) {
+			(*set)[i] = false;
+		}
+	}
+}
+
+bool SearchIndex::open(const string& dbfile) {
+	have_trigram = trigram.open((dbfile + TrigramIndex::suffix).c_str(), dbfile.c_str());
+	have_fuzzy = fuzzy.open((dbfile + FuzzyIndex::suffix).c_str(), dbfile.c_str());
+	have_revdep = revdep.open((dbfile + ReverseDependIndex::suffix).c_str(), dbfile.c_str());
+	return (have_trigram || have_fuzzy || have_revdep);
+}
+
+/**
+The reverse dependency index restricts independently of stringMatch.
+If it restricts, installed packages outside of set cannot match.
+**/
+bool PackageTest::candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *maybe_installed) const {
+	bool restricted(false);
+	TrigramIndex::PackageSet other;
+	if((required_by_list != NULLPTR) && index->have_revdep) {
+		for(vector<string>::const_iterator it(required_by_list->begin());
+			likely(it != required_by_list->end()); ++it) {
+			if(!restricted) {
+				restricted = index->revdep.lookup(set, *it, required_by_classes);
+			} else if(index->revdep.lookup(&other, *it, required_by_classes)) {
+				intersect(set, other);
+			}
+		}
+	}
+	if(!restricted) {
+		return stringCandidates(index, set, maybe_installed);
+	}
+	bool ignore_installed(false);
+	if(stringCandidates(index, &other, &ignore_installed)) {
+		intersect(set, other);
+	}
+	return true;
+}
+
+
+/**
+All tests are combined with "and", so it suffices to consider stringMatch
+if it is restricted to fields covered by the index.
+The fuzzy index covers only the names.
+**/
+bool PackageTest::stringCandidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *maybe_installed) const {
+	if(algorithm == NULLPTR) {
+		return false;
+	}
+	string s;
+	Levenshtein max;
+	if(algorithm->neighbourhood(&s, &max)) {
+		return ((field == NAME) && index->have_fuzzy &&
+			index->fuzzy.lookup(set, s, max));
+	}
+	if(!index->have_trigram || ((field & ~(NAME | DESCRIPTION | LICENSE |
+		CATEGORY | CATEGORY_NAME | HOMEPAGE | SRC_URI | DEPS)) != NONE)) {
+		return false;
+	}
+	if(!algorithm->literal(&s) || !index->trigram.lookup(set, s)) {
+		return false;
+	}
+	if((field & DEPSI) != NONE) {
+		*maybe_installed = true;
+	}
+	return true;
+}
+
 bool PackageTest::have_redundant(const Package& p, Keywords::Redundant r, const RedAtom& t) const {
 	r &= t.red;
 	if(r == Keywords::RED_NOTHING) {
@@ -981,6 +1124,23 @@ bool PackageTest::match(PackageReader *pkg) const {
 		}
 	}
 
+	if(unlikely(required_by_list != NULLPTR)) {
+		// --required-by
+		get_p(&p, pkg);
+		for(vector<string>::const_iterator it(required_by_list->begin());
+			likely(it != required_by_list->end()); ++it) {
+			Package::const_iterator v(p->begin());
+			for(; likely(v != p->end()); ++v) {
+				if((v->depend.atom_classes(*it) & required_by_classes) != Depend::CLASS_NONE) {
+					break;
+				}
+			}
+			if(v == p->end()) {
+				return false;
+			}
+		}
+	}
+
 	if(unlikely(marked_list != NULLPTR)) {
 		get_p(&p, pkg);
 		if(likely(!marked_list->MaskMatches(p))) {
@@ -16,15 +16,20 @@
 #include <string>
 #include <vector>
 
+#include "database/fuzzy.h"
 #include "database/package_reader.h"
+#include "database/revdep.h"
+#include "database/trigram.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "portage/depend.h"
 #include "portage/extendedversion.h"
 #include "portage/keywords.h"
 #include "portage/package.h"
+#include "portage/packagesets.h"
 #include "portage/set_stability.h"
 #include "search/redundancy.h"
 
@@ -39,6 +44,26 @@ class PrintFormat;
 class VarDbPkg;
 template<typename m_Type> class MaskList;
 
+/**
+The indices of a database which can restrict the candidates of a search
+**/
+class SearchIndex {
+	public:
+		TrigramIndex trigram;
+		FuzzyIndex fuzzy;
+		ReverseDependIndex revdep;
+		bool have_trigram, have_fuzzy, have_revdep;
+
+		SearchIndex() : have_trigram(false), have_fuzzy(false), have_revdep(false) {
+		}
+
+		/**
+		Open the indices which belong to dbfile
+		@return false if there is none
+		**/
+		bool open(const std::string& dbfile);
+};
+
 /**
 Test a package if it matches some criteria
 **/
@@ -98,6 +123,17 @@ class PackageTest {
 			ALGO_ERROR
 		};
 
+		/**
+		Rough estimate of the cost of a test, used to plan the evaluation
+		**/
+		typedef unsigned int Cost;
+		static CONSTEXPR const Cost
+			COST_NAME      =  1U,  ///< Test category or name
+			COST_TEXT      =  2U,  ///< Read description, homepage or license
+			COST_VERSIONS  =  8U,  ///< Decode the versions
+			COST_STABILITY = 32U,  ///< Recalculate the stability of versions
+			COST_VARDB     = 64U;  ///< Read data of installed packages
+
 		typedef uint8_t TestInstalled;
 		static CONSTEXPR const TestInstalled
 			INS_NONE        = 0x00U,
@@ -131,11 +167,32 @@ class PackageTest {
 
 		bool match(PackageReader *pkg) const;
 
+		/**
+		Use index to restrict the packages which can possibly match.
+		@arg maybe_installed is set if also installed packages outside of
+		set might match
+		@return false if no restriction is possible
+		**/
+		ATTRIBUTE_NONNULL_ bool candidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *maybe_installed) const;
+
 		/**
 		Set defaults (e.g. matchfield if unspecified), calculate needs
 		**/
 		void finalize();
 
+		/**
+		@return estimated cost of match(); valid after finalize()
+		**/
+		Cost cost() const {
+			return estimated_cost;
+		}
+
+		/**
+		@return true if match() has side effects so that it must not be
+		skipped or evaluated in a different order
+		**/
+		bool pinned() const;
+
 		/*
 		The constructor of the class *must* set the least restrictive choice.
 		Since --selected --world must act like --selected, the less restrictive
@@ -276,6 +333,21 @@ class PackageTest {
 			return from_foreign_overlay_inst_list;
 		}
 
+		/**
+		The category/name of atoms on which some version must depend
+		**/
+		std::vector<std::string> *RequiredByList() {
+			if(likely(required_by_list == NULLPTR))
+				required_by_list = new std::vector<std::string>;
+			return required_by_list;
+		}
+
+		/**
+		Set the classes of dependencies considered for RequiredByList()
+		from a list like "rdepend,pdepend"
+		**/
+		void RequiredByClasses(const std::string& classes);
+
 		void DuplVersions(bool only_overlay) {
 			dup_versions = true;
 			dup_versions_overlay = only_overlay;
@@ -331,6 +403,11 @@ class PackageTest {
 		What we need to read so we can do our testing
 		**/
 		PackageReader::Attributes need;
+
+		/**
+		Estimated cost of match()
+		**/
+		Cost estimated_cost;
 		/**
 		Our string matching algorithm
 		**/
@@ -360,10 +437,17 @@ class PackageTest {
 		std::set<ExtendedVersion::Overlay> *from_overlay_inst_list;
 		std::vector<std::string> *from_foreign_overlay_inst_list;
 
+		std::vector<std::string> *required_by_list;
+		Depend::Classes required_by_classes;
+
 		MaskList<Mask> *marked_list;
 
 		PortageSettings *portagesettings;
 		/**
+		The local sets whose names match for the SET field
+		**/
+		SetsBits set_matches;
+		/**
 		Lookup stuff about user flags here
 		**/
 		const SetStability *stability,
@@ -386,6 +470,11 @@ class PackageTest {
 
 		ATTRIBUTE_NONNULL_ bool stringMatch(Package *pkg) const;
 
+		/**
+		The part of candidates() for stringMatch()
+		**/
+		ATTRIBUTE_NONNULL_ bool stringCandidates(SearchIndex *index, TrigramIndex::PackageSet *set, bool *maybe_installed) const;
+
 		void setNeeds(const PackageReader::Attributes i) {
 			if(need < i) {
 				need = i;
@@ -397,6 +486,16 @@ class PackageTest {
 		**/
 		void calculateNeeds();
 
+		/**
+		Estimate the cost of match(); needs must have been calculated
+		**/
+		void calculateCost();
+
+		/**
+		Calculate set_matches; the algorithm must have been set
+		**/
+		void calculateSetMatches();
+
 		bool have_redundant(const Package& p, Keywords::Redundant r, const RedAtom& t) const;
 		bool have_redundant(const Package& p, Keywords::Redundant r) const;
 		ATTRIBUTE_NONNULL_ bool instabilitytest(const Package *p, TestStability what) const;
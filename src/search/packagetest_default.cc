@@ -27,6 +27,7 @@
 #include "eixTk/unordered_map.h"
 #include "eixrc/eixrc.h"
 #include "eixrc/global.h"
+#include "portage/depend.h"
 #include "search/algorithms.h"
 #include "search/nowarn.h"
 
@@ -421,3 +422,12 @@ void PackageTest::init_static() {
 	init_match_field_map();
 	init_match_algorithm_map();
 }
+
+void PackageTest::RequiredByClasses(const string& classes) {
+	if(unlikely(!Depend::parse_classes(&required_by_classes, classes))) {
+		eix::say_error(_("invalid dependency classes \"%s\" for --required-by-class\n"
+			"Use a list of depend, rdepend, pdepend, bdepend, idepend."))
+			% classes;
+		std::exit(EXIT_FAILURE);
+	}
+}
@@ -285,6 +285,16 @@ void parse_cli(MatchTree *matchtree, EixRc *eixrc, VarDbPkg *varpkg_db, PortageS
 				// test->FromForeignOverlayInstList()->PUSH_BACK("");
 				test->FromForeignOverlayInstList()->push_back("");
 				break;
+			case O_REQUIRED_BY: USE_TEST;
+				if(likely(optional_increase(&arg, ar))) {
+					test->RequiredByList()->PUSH_BACK(arg->m_argument);
+				}
+				break;
+			case O_REQUIRED_BY_CLASS: USE_TEST;
+				if(likely(optional_increase(&arg, ar))) {
+					test->RequiredByClasses(arg->m_argument);
+				}
+				break;
 			case 'd': USE_TEST;
 				test->DuplPackages(eixrc->getBool("DUP_PACKAGES_ONLY_OVERLAYS"));
 				break;
@@ -103,7 +103,13 @@ enum cli_options {
 	O_INSTALLED_WITH_USE,
 	O_INSTALLED_WITHOUT_USE,
 	O_FROM_OVERLAY,
+	O_REQUIRED_BY,
+	O_REQUIRED_BY_CLASS,
 	O_EIX_CACHEFILE,
+	O_BATCH,
+	O_BATCH_NULL,
+	O_LIST_QUERY_CACHE,
+	O_PURGE_QUERY_CACHE,
 	O_NONVIRTUAL,
 	O_VIRTUAL,
 	O_DEBUG,
@@ -0,0 +1,392 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "various/querycache.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/diagnostics.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
+#include "eixTk/utils.h"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+static CONSTEXPR const char magic[] = "eix-query-cache";
+static CONSTEXPR const char entry_suffix[] = ".query";
+static CONSTEXPR const char tmp_prefix[] = ".tmp-query.";
+
+QueryCache *QueryCache::capturing = NULLPTR;
+
+/**
+A parsed entry of the cache
+**/
+class QueryEntry {
+	public:
+		typedef pair<string, string> SignedFile;
+		typedef vector<SignedFile> SignedFiles;
+
+		QueryCache::Status status;
+		string title, key, output;
+		SignedFiles files;
+
+		/**
+		@return false if the file is missing or not a valid entry
+		**/
+		ATTRIBUTE_NONNULL_ bool read(const char *filename);
+
+		/**
+		@return true if all files still have their signature
+		**/
+		bool valid() const;
+};
+
+ATTRIBUTE_NONNULL_ static bool read_file(string *data, const char *filename);
+ATTRIBUTE_NONNULL_ static bool parse_line(string *line, const string& data, string::size_type *pos);
+ATTRIBUTE_NONNULL_ static bool parse_block(string *block, const string& data, string::size_type *pos);
+ATTRIBUTE_NONNULL_ static bool parse_number(eix::UNumber *num, const string& data, string::size_type *pos);
+static string key_filename(const string& key);
+ATTRIBUTE_NONNULL_ static bool write_all(int fd, const char *data, string::size_type len);
+static bool is_entry(const string& name);
+
+static bool read_file(string *data, const char *filename) {
+	FILE *fp(std::fopen(filename, "rb"));
+	if(fp == NULLPTR) {
+		return false;
+	}
+	data->clear();
+	char buf[8192];
+	size_t len;
+	while((len = std::fread(buf, 1, sizeof(buf), fp)) != 0) {
+		data->append(buf, len);
+	}
+	bool ok(std::ferror(fp) == 0);
+	std::fclose(fp);
+	return ok;
+}
+
+static bool parse_line(string *line, const string& data, string::size_type *pos) {
+	string::size_type end(data.find('\n', *pos));
+	if(unlikely(end == string::npos)) {
+		return false;
+	}
+	line->assign(data, *pos, end - *pos);
+	*pos = end + 1;
+	return true;
+}
+
+/**
+A block consists of its length, a newline, and the data
+**/
+static bool parse_block(string *block, const string& data, string::size_type *pos) {
+	eix::UNumber len;
+	if(unlikely(!parse_number(&len, data, pos) || (len > data.size() - *pos))) {
+		return false;
+	}
+	block->assign(data, *pos, len);
+	*pos += len;
+	return true;
+}
+
+static bool parse_number(eix::UNumber *num, const string& data, string::size_type *pos) {
+	string line;
+	if(unlikely(!parse_line(&line, data, pos) || line.empty() ||
+		!is_numeric(line.c_str()))) {
+		return false;
+	}
+	*num = my_atou(line.c_str());
+	return true;
+}
+
+/**
+FNV-1a hash of the key; collisions are detected by comparing the key
+**/
+static string key_filename(const string& key) {
+	uint32_t hash(0x811C9DC5U);
+	for(string::const_iterator it(key.begin()); likely(it != key.end()); ++it) {
+		hash ^= static_cast<unsigned char>(*it);
+		hash *= 0x1000193U;
+	}
+	static CONSTEXPR const char hex[] = "0123456789abcdef";
+	string ret;
+	for(int i(28); likely(i >= 0); i -= 4) {
+		ret.append(1, hex[(hash >> i) & 0xFU]);
+	}
+	ret.append(entry_suffix);
+	return ret;
+}
+
+static bool write_all(int fd, const char *data, string::size_type len) {
+	while(len != 0) {
+		ssize_t written(write(fd, data, len));
+		if(unlikely(written < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+GCC_DIAG_OFF(sign-conversion)
+		data += written;
+		len -= written;
+GCC_DIAG_ON(sign-conversion)
+	}
+	return true;
+}
+
+static bool is_entry(const string& name) {
+	string::size_type len(std::strlen(entry_suffix));
+	return ((name.size() > len) &&
+		(name.compare(name.size() - len, len, entry_suffix) == 0));
+}
+
+bool QueryEntry::read(const char *filename) {
+	string data;
+	if(!read_file(&data, filename)) {
+		return false;
+	}
+	string::size_type pos(0);
+	string line;
+	eix::UNumber num;
+	if(unlikely(!parse_line(&line, data, &pos) || (line != magic) ||
+		!parse_number(&num, data, &pos))) {
+		return false;
+	}
+	status = static_cast<QueryCache::Status>(num);
+	if(unlikely(!parse_line(&title, data, &pos) ||
+		!parse_block(&key, data, &pos) ||
+		!parse_number(&num, data, &pos))) {
+		return false;
+	}
+	files.clear();
+	for(; likely(num != 0); --num) {
+		if(unlikely(!parse_line(&line, data, &pos))) {
+			return false;
+		}
+		string::size_type tab(line.find('\t'));
+		if(unlikely(tab == string::npos)) {
+			return false;
+		}
+		files.PUSH_BACK(SignedFile(line.substr(tab + 1), line.substr(0, tab)));
+	}
+	return parse_block(&output, data, &pos);
+}
+
+bool QueryEntry::valid() const {
+	string sig;
+	for(SignedFiles::const_iterator it(files.begin()); likely(it != files.end()); ++it) {
+		file_signature(&sig, it->first);
+		if(sig != it->second) {
+			return false;
+		}
+	}
+	return true;
+}
+
+QueryCache::QueryCache(const string& dir, const string& key, const string& title) :
+	m_dir(dir), m_key(key), m_title(title), m_start(0), m_saved_stdout(-1), m_tmp_fd(-1) {
+	m_filename = m_dir + "/" + key_filename(m_key);
+	string::size_type pos;
+	while((pos = m_title.find('\n')) != string::npos) {
+		m_title[pos] = ' ';
+	}
+}
+
+QueryCache::~QueryCache() {
+	if(unlikely(capturing == this)) {
+		string output;
+		end_capture(&output);
+	}
+	if(!m_tmpname.empty()) {
+		unlink(m_tmpname.c_str());
+	}
+}
+
+bool QueryCache::lookup(Status *status) {
+	QueryEntry entry;
+	if(!entry.read(m_filename.c_str()) || (entry.key != m_key) || !entry.valid()) {
+		return false;
+	}
+	std::fwrite(entry.output.c_str(), 1, entry.output.size(), stdout);
+	std::fflush(stdout);
+	*status = entry.status;
+	return true;
+}
+
+bool QueryCache::start(const WordVec& watch) {
+	if((mkdir(m_dir.c_str(), 0775) != 0) && (errno != EEXIST)) {
+		return false;
+	}
+	string tmpl(m_dir + "/" + tmp_prefix + "XXXXXX");
+	vector<char> name(tmpl.begin(), tmpl.end());
+	name.PUSH_BACK('\0');
+	m_tmp_fd = mkstemp(&(name[0]));
+	if(m_tmp_fd < 0) {
+		return false;
+	}
+	m_tmpname.assign(&(name[0]));
+	fchmod(m_tmp_fd, 0664);
+	std::fflush(stdout);
+	std::cout.flush();
+	m_saved_stdout = dup(1);
+	if(unlikely((m_saved_stdout < 0) || (dup2(m_tmp_fd, 1) < 0))) {
+		if(m_saved_stdout >= 0) {
+			close(m_saved_stdout);
+		}
+		close(m_tmp_fd);
+		return false;
+	}
+	m_files.insert(watch.begin(), watch.end());
+	record_read_files(&m_files);
+	m_start = std::time(NULLPTR);
+	capturing = this;
+	static bool registered(false);
+	if(!registered) {
+		registered = true;
+		std::atexit(abort_capture);
+	}
+	return true;
+}
+
+bool QueryCache::end_capture(string *output) {
+	capturing = NULLPTR;
+	record_read_files(NULLPTR);
+	std::fflush(stdout);
+	std::cout.flush();
+	dup2(m_saved_stdout, 1);
+	close(m_saved_stdout);
+	bool ok(lseek(m_tmp_fd, 0, SEEK_SET) == 0);
+	output->clear();
+	char buf[8192];
+	ssize_t len;
+	while(likely(ok) && ((len = ::read(m_tmp_fd, buf, sizeof(buf))) != 0)) {
+		if(unlikely(len < 0)) {
+			if(errno != EINTR) {
+				ok = false;
+			}
+			continue;
+		}
+GCC_DIAG_OFF(sign-conversion)
+		output->append(buf, len);
+GCC_DIAG_ON(sign-conversion)
+	}
+	close(m_tmp_fd);
+	write_all(1, output->c_str(), output->size());
+	return ok;
+}
+
+void QueryCache::abort_capture() {
+	QueryCache *cache(capturing);
+	if(cache != NULLPTR) {
+		string output;
+		cache->end_capture(&output);
+		unlink(cache->m_tmpname.c_str());
+		cache->m_tmpname.clear();
+	}
+}
+
+void QueryCache::finish(Status status) {
+	if(capturing != this) {
+		return;
+	}
+	string output;
+	if(unlikely(!end_capture(&output))) {
+		return;
+	}
+	string entry(eix::format("%s\n%s\n%s\n%s\n%s%s\n")
+		% magic % status % m_title % m_key.size() % m_key % m_files.size());
+	string sig;
+	for(WordSet::const_iterator it(m_files.begin()); likely(it != m_files.end()); ++it) {
+		if(unlikely(file_signature(&sig, *it) >= m_start)) {
+			return;
+		}
+		entry.append(sig);
+		entry.append(1, '\t');
+		entry.append(*it);
+		entry.append(1, '\n');
+	}
+	entry.append(eix::format("%s\n") % output.size());
+	entry.append(output);
+	FILE *fp(std::fopen(m_tmpname.c_str(), "wb"));
+	if(unlikely(fp == NULLPTR)) {
+		return;
+	}
+	bool ok(std::fwrite(entry.c_str(), 1, entry.size(), fp) == entry.size());
+	if(unlikely(std::fclose(fp) != 0)) {
+		ok = false;
+	}
+	if(likely(ok) && likely(std::rename(m_tmpname.c_str(), m_filename.c_str()) == 0)) {
+		m_tmpname.clear();
+	}
+}
+
+bool QueryCache::list(const string& dir) {
+	WordVec names;
+	if(!pushback_files(dir, &names, NULLPTR, 1, true, false)) {
+		return false;
+	}
+	for(WordVec::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		if(!is_entry(*it)) {
+			continue;
+		}
+		QueryEntry entry;
+		if(!entry.read((dir + "/" + *it).c_str())) {
+			continue;
+		}
+		eix::say("%s %s %s")
+			% (entry.valid() ? _("valid") : _("stale"))
+			% entry.output.size() % entry.title;
+	}
+	return true;
+}
+
+bool QueryCache::purge(const string& dir) {
+	WordVec names;
+	if(!pushback_files(dir, &names, NULLPTR, 1, false, false)) {
+		return true;
+	}
+	bool ok(true);
+	for(WordVec::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		string file(dir + "/" + *it);
+		if(is_entry(*it)) {
+			QueryEntry entry;
+			if(!entry.read(file.c_str())) {
+				continue;
+			}
+		} else if(it->compare(0, std::strlen(tmp_prefix), tmp_prefix) != 0) {
+			continue;
+		}
+		if(unlikely(unlink(file.c_str()) != 0)) {
+			eix::say_error(_("cannot remove %s: %s")) % file % std::strerror(errno);
+			ok = false;
+		}
+	}
+	return ok;
+}
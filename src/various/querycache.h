@@ -0,0 +1,93 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_VARIOUS_QUERYCACHE_H_
+#define SRC_VARIOUS_QUERYCACHE_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <ctime>
+
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/stringtypes.h"
+
+/**
+A cache of the output of eix queries.
+An entry is stored under a key formed from the command line and all
+settings which influence the output. It is valid as long as all files
+and directories which were read for it (including the database) have
+the same inode, size, and mtime as when the entry was stored.
+**/
+class QueryCache {
+	public:
+		typedef int Status;
+
+		/**
+		@param dir the directory of the entries
+		@param key the key of the query
+		@param title describes the query when listing the entries
+		**/
+		QueryCache(const std::string& dir, const std::string& key, const std::string& title);
+
+		~QueryCache();
+
+		/**
+		If a valid entry exists, print its output and set *status.
+		@return true if the query was answered from the cache
+		**/
+		ATTRIBUTE_NONNULL_ bool lookup(Status *status);
+
+		/**
+		Start to capture stdout and to record the files which are read.
+		The files and directories of watch are also considered.
+		@return false if nothing can be stored
+		**/
+		bool start(const WordVec& watch);
+
+		/**
+		Stop capturing: print the output and store it in the cache
+		**/
+		void finish(Status status);
+
+		/**
+		Print all entries of dir with their state.
+		@return false if dir cannot be read
+		**/
+		static bool list(const std::string& dir);
+
+		/**
+		Remove all entries of dir.
+		@return false if some entry cannot be removed
+		**/
+		static bool purge(const std::string& dir);
+
+	private:
+		std::string m_dir, m_key, m_title, m_filename, m_tmpname;
+		WordSet m_files;
+		std::time_t m_start;
+		int m_saved_stdout, m_tmp_fd;
+
+		/**
+		The cache whose capture must be ended if the program exits
+		**/
+		static QueryCache *capturing;
+
+		/**
+		Restore stdout and print the captured output *output.
+		@return false if the output cannot be read completely
+		**/
+		ATTRIBUTE_NONNULL_ bool end_capture(std::string *output);
+
+		/**
+		Called at exit if finish() was not called
+		**/
+		static void abort_capture();
+};
+
+#endif  // SRC_VARIOUS_QUERYCACHE_H_